@@ -3,24 +3,60 @@
 \brief Определение класса allocator::superK
 
 Заголовочный файл с определением класса allocator::superK. 
-Аллокатор позволяет использовать до 1024 байт для 
-размещения данных стандартных контейнеров любых типов. 
-Выделение памяти для блока происходит 1 раз в начале работы
-программы. Размер блока может быть изменен константой 
-sizeofblock.
-Для каждого уникального типа данных Т можно установить лимит
+Аллокатор размещает данные стандартных контейнеров любых типов
+в общем блоке памяти membuf. Блок начинается с куска размером 
+sizeofblock байт и при нехватке места наращивается новыми кусками 
+геометрически растущего размера; размещенные объекты не перемещаются.
+Освобожденные блоки хранятся в списках по размерным
+классам и переиспользуются, поэтому контейнеры, освобождающие 
+элементы в произвольном порядке (std::map, std::set), не исчерпывают блок.
+Аллокатор superK<T, concurrent> предназначен для контейнеров, с которыми
+работают несколько потоков: каждый поток размещает данные в собственном 
+блоке thread_membuf без блокировок, учет по типам ведется атомарно, 
+а память можно освобождать из любого потока.
+Аллокатор может ссылаться на собственный блок памяти (superK(membuf&) 
+или superK<T>::make_private()), тогда контейнер не делит память и лимиты
+с другими контейнерами, а блок освобождается целиком вместе с ним.
+Объекты размещаются с выравниванием alignof(T); для отдельного типа его
+можно увеличить функцией set_alignment(), например до cache_line_alignment.
+Куски блока membuf могут браться через mmap с большими страницами и 
+предварительным заполнением (arena_options::backing, huge_pages, prefault).
+Статистику можно получить в любой момент снимком: superK<T>::stats() 
+по типу T и membuf::stats() по блоку памяти в целом, а последовательность
+событий по времени - журналом trace::recorder (slvr_trace.h).
+Область arena_scope освобождает все, что размещено в блоке после ее
+создания, одним действием при выходе, без поэлементных destroy и deallocate.
+Для каждого уникального типа данных Т в каждом блоке памяти можно установить лимит
 суммарного количества размещаемых элементов с помощью функции
-allocator_obj.set_limit(n) - при условии, что n- больше уже 
-размещенного количества элементов и меньше размера общего 
-выделенного блока памяти. Для снятия ограничения нужно 
+allocator_obj.set_limit(n) - при условии, что n не меньше уже 
+размещенного количества элементов. Лимит не зависит от размера 
+блока памяти. Для снятия ограничения нужно 
 использовать n=0.
 */
 #ifndef SLVR_ALLOCATOR_H_
 #define SLVR_ALLOCATOR_H_
 
-#include <iostream>
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <iterator>
 #include <limits>
+#include <memory>
+#include <stdexcept>
+#include <type_traits>
 #include <typeinfo>
+#include <utility>
+#include <vector>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <sys/mman.h>
+#include <unistd.h>
+#define SLVR_HAS_MMAP 1
+#endif
+
+#include "slvr_trace.h"
 
 namespace slvr
 {
@@ -28,88 +64,991 @@ namespace slvr
     {
         constexpr size_t sizeofblock = 1024;
 
+        /// Выравнивание по строке кэша: блоки разных арен не делят строку
+        constexpr size_t cache_line_alignment = 64;
+        /// Выравнивание для векторных загрузок AVX
+        constexpr size_t simd_alignment = 32;
+
+        /// Шаг мелких размерных классов: свободный блок должен вмещать указатель
+        constexpr size_t size_quantum = sizeof(void *);
+        /// Верхняя граница мелких блоков, которые округляются до size_quantum
+        constexpr size_t small_size_max = 512;
+        constexpr size_t small_classes = small_size_max / size_quantum;
+        /// Число классов на каждую степень двойки для крупных блоков
+        constexpr size_t class_subdivisions = 4;
+        constexpr size_t size_classes =
+            small_classes +
+            class_subdivisions * (std::numeric_limits<size_t>::digits - 9);
+
+        /// Номер размерного класса для блока в bytes байт
+        inline size_t size_class(size_t bytes)
+        {
+            if (bytes <= small_size_max)
+                return bytes == 0 ? 0 : (bytes + size_quantum - 1) / size_quantum - 1;
+            size_t b = bytes - 1;
+            size_t e = std::numeric_limits<unsigned long long>::digits - 1 -
+                       __builtin_clzll(static_cast<unsigned long long>(b));
+            size_t sub = (b >> (e - 2)) & (class_subdivisions - 1);
+            return small_classes + (e - 9) * class_subdivisions + sub;
+        }
+
+        /// Фактический размер блока размерного класса cls
+        inline size_t class_size(size_t cls)
+        {
+            if (cls < small_classes)
+                return (cls + 1) * size_quantum;
+            size_t e = (cls - small_classes) / class_subdivisions + 9;
+            size_t sub = (cls - small_classes) % class_subdivisions;
+            return (class_subdivisions + sub + 1) << (e - 2);
+        }
+
+        /// Режим superK по умолчанию: общий блок buffer, без синхронизации
+        struct single_threaded
+        {
+        };
+
+        /// Режим superK для многопоточной работы: у каждого потока свой блок
+        struct concurrent
+        {
+        };
+
+        /// Счетчик учета superK: обычная переменная или atomic в режиме concurrent
+        template <typename V, typename Mode>
+        class counter
+        {
+        public:
+            explicit counter(V v = V()) : value(v) {}
+            V load() const { return value; }
+            void store(V v) { value = v; }
+            V add(V change) { return value += change; }
+            void raise(V v)
+            {
+                if (v > value)
+                    value = v;
+            }
+
+        private:
+            V value;
+        };
+
+        template <typename V>
+        class counter<V, concurrent>
+        {
+        public:
+            explicit counter(V v = V()) : value(v) {}
+            V load() const { return value.load(std::memory_order_relaxed); }
+            void store(V v) { value.store(v, std::memory_order_relaxed); }
+            V add(V change) { return value.fetch_add(change, std::memory_order_relaxed) + change; }
+            void raise(V v)
+            {
+                V current = value.load(std::memory_order_relaxed);
+                while (v > current &&
+                       !value.compare_exchange_weak(current, v, std::memory_order_relaxed))
+                    ;
+            }
+
+        private:
+            std::atomic<V> value;
+        };
+
+        /// Лимит, количество размещенных элементов одного типа и статистика по ним
+        template <typename Mode>
+        struct quota
+        {
+            counter<size_t, Mode> max_n{0};
+            counter<signed long long, Mode> total{0};
+            counter<size_t, Mode> align{0};
+            counter<signed long long, Mode> peak{0};
+            counter<size_t, Mode> allocations{0};
+            counter<size_t, Mode> failures{0};
+        };
+
+        /// Снимок статистики superK по одному типу элементов в одном блоке памяти
+        struct type_stats
+        {
+            size_t live_objects = 0;
+            size_t live_bytes = 0;
+            size_t peak_objects = 0;
+            size_t peak_bytes = 0;
+            size_t allocations = 0;
+            size_t failures = 0;
+            size_t limit = 0;
+            size_t alignment = 0;
+        };
+
+        /// Снимок статистики блока памяти membuf
+        struct arena_stats
+        {
+            /// Память, полученная от системы
+            size_t reserved = 0;
+            size_t chunks = 0;
+            size_t live_blocks = 0;
+            /// Объем живых блоков с учетом округления до размерного класса
+            size_t live_bytes = 0;
+            size_t peak_bytes = 0;
+            size_t allocations = 0;
+            size_t deallocations = 0;
+            size_t failures = 0;
+            /// Байты в списках свободных блоков: потери от освобождения не с конца
+            size_t free_list_bytes = 0;
+            /// Неиспользованные хвосты кусков, оставленных при переходе к новому куску
+            size_t chunk_tail_bytes = 0;
+            /// Количество размещений по размерам блоков: пары (размер класса, число)
+            std::vector<std::pair<size_t, size_t>> histogram;
+        };
+
+        /// Номер типа для блоков, размещенных без учета по типам
+        constexpr size_t untyped = std::numeric_limits<size_t>::max();
+
+        inline size_t next_type_id()
+        {
+            static std::atomic<size_t> last_id{0};
+            return last_id.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        /// Порядковый номер типа T для учета в membuf
+        template <typename T>
+        size_t type_id()
+        {
+            static const size_t id = next_type_id();
+            return id;
+        }
+
+        /// Источник памяти для кусков membuf
+        enum class backing_store
+        {
+            /// std::aligned_alloc
+            heap,
+            /// Анонимное отображение mmap, страницы дальше retain_bytes возвращаются системе при сбросе блока
+            mmap
+        };
+
+        /// Параметры блока памяти membuf
+        struct arena_options
+        {
+            /// Размер первого куска памяти
+            size_t initial_size = sizeofblock;
+            /// Во сколько раз следующий кусок больше предыдущего
+            size_t growth_factor = 2;
+            backing_store backing = backing_store::heap;
+            /// Для mmap: просить у ядра прозрачные большие страницы (MADV_HUGEPAGE)
+            bool huge_pages = false;
+            /// Для mmap: заполнить страницы сразу при создании куска (MAP_POPULATE)
+            bool prefault = false;
+            /// Для mmap: сколько байт начала куска остается за процессом при сбросе блока
+            size_t retain_bytes = 1 << 20;
+        };
+
+        /**
+        Блок памяти, из которого superK размещает объекты.
+        Блок состоит из цепочки кусков, выровненных по строке кэша и 
+        полученных от std::aligned_alloc или mmap (arena_options::backing).
+        Память выдается сдвигом указателя ptr внутри текущего куска с 
+        выравниванием, запрошенным для блока; пропуск перед выровненным 
+        блоком попадает в список свободных блоков. Когда место заканчивается,
+        к цепочке добавляется новый кусок, в growth_factor раз больше 
+        предыдущего. Уже выданные адреса при этом не меняются.
+        Освобожденный последний блок возвращается сдвигом ptr назад, а любой 
+        другой попадает в список свободных блоков своего размерного класса и 
+        переиспользуется при следующем запросе того же класса за O(1).
+        Все, что размещено после отметки arena_scope, освобождается разом
+        при выходе из области.
+        */
         class membuf
         {
+            friend class arena_scope;
+
         public:
-            membuf()
+            explicit membuf(const arena_options &opts = arena_options{})
+                : options(opts), head(nullptr), ptr(nullptr), end(nullptr), peak(nullptr),
+                  next_size(opts.initial_size), blocks(0), chunks_count(0)
+            {
+                if (options.growth_factor < 1)
+                    options.growth_factor = 1;
+                std::fill(std::begin(free_heads), std::end(free_heads), nullptr);
+                add_chunk(0);
+            }
+
+            membuf(const membuf &) = delete;
+            membuf &operator=(const membuf &) = delete;
+
+            ~membuf()
+            {
+                run_finalizers(nullptr);
+                release_chunks();
+            }
+
+            /// id - номер типа для учета в arena_scope (type_id<T>())
+            char *place(std::size_t n, std::size_t bytes_per_obj,
+                        std::size_t alignment = size_quantum, std::size_t id = untyped)
             {
-                pbegin = std::malloc(sizeofblock);
-                if (!pbegin)
+                if ((bytes_per_obj != 0 &&
+                     n > (std::numeric_limits<size_t>::max() / 2) / bytes_per_obj) ||
+                    (alignment & (alignment - 1)))
                 {
+                    ++counters.failures;
                     throw std::bad_alloc();
                 }
-                begin = 0;
-                end = sizeofblock;
-                ptr = 0;
-                used = 0;
+                alignment = std::max(alignment, size_quantum);
+                size_t cls = size_class(n * bytes_per_obj);
+                size_t bytes = class_size(cls);
+                char *p = nullptr;
+                if (free_heads[cls] && is_aligned(free_heads[cls], alignment))
+                {
+                    p = reinterpret_cast<char *>(free_heads[cls]);
+                    free_heads[cls] = free_heads[cls]->next;
+                    counters.free_list_bytes -= bytes;
+                }
+                else
+                {
+                    size_t gap = padding(ptr, alignment);
+                    if (gap + bytes > static_cast<size_t>(end - ptr))
+                    {
+                        add_chunk(bytes + alignment);
+                        gap = padding(ptr, alignment);
+                    }
+                    keep_gap(ptr, gap);
+                    p = ptr + gap;
+                    ptr = p + bytes;
+                    if (ptr > peak)
+                        peak = ptr;
+                }
+                ++blocks;
+                ++counters.allocations;
+                ++counters.class_hits[cls];
+                counters.live_bytes += bytes;
+                if (counters.live_bytes > counters.peak_bytes)
+                    counters.peak_bytes = counters.live_bytes;
+                if (scopes)
+                {
+                    ++scopes->live_blocks;
+                    scopes->live_bytes += bytes;
+                    scopes->count(id, static_cast<long long>(n), bytes_per_obj);
+                }
+                return p;
             }
 
-            ~membuf()
+            void clean(char *p, std::size_t n, std::size_t bytes_per_obj, std::size_t id = untyped)
+            {
+                size_t cls = size_class(n * bytes_per_obj);
+                size_t bytes = class_size(cls);
+                ++counters.deallocations;
+                counters.live_bytes -= bytes;
+                // Блок возвращается в списки той области, в которой был размещен
+                free_node **lists = free_heads;
+                size_t *stash_bytes = nullptr;
+                for (scope_state *s = scopes; s; s = s->outer)
+                {
+                    if (in_scope(*s, p))
+                    {
+                        --s->live_blocks;
+                        s->live_bytes -= bytes;
+                        s->count(id, -static_cast<long long>(n), bytes_per_obj);
+                        break;
+                    }
+                    lists = s->stash;
+                    stash_bytes = &s->stash_bytes;
+                }
+                if (lists == free_heads && p + bytes == ptr)
+                    ptr = p;
+                else
+                {
+                    auto node = reinterpret_cast<free_node *>(p);
+                    node->next = lists[cls];
+                    lists[cls] = node;
+                    counters.free_list_bytes += bytes;
+                    if (stash_bytes)
+                        *stash_bytes += bytes;
+                }
+                if (--blocks == 0 && !scopes)
+                    reset();
+                return;
+            }
+
+            /**
+            Объект T в блоке памяти. Его деструктор, если он нетривиален,
+            вызывается при выходе из arena_scope, внутри которой объект
+            создан, или при удалении блока; память освобождается так же.
+            */
+            template <typename T, typename... Args>
+            T *create(Args &&... args)
+            {
+                return make<T, !std::is_trivially_destructible<T>::value>(std::forward<Args>(args)...);
+            }
+
+            /**
+            Объект T, деструктор которого не вызывается никогда. Например
+            контейнер на superK этого блока с тривиально разрушаемыми
+            элементами: вся его память уходит вместе с областью без обхода.
+            */
+            template <typename T, typename... Args>
+            T *create_unmanaged(Args &&... args)
+            {
+                return make<T, false>(std::forward<Args>(args)...);
+            }
+
+            /**
+            Изменение размера блока p на месте: возможно, только если блок 
+            последний в текущем куске и новый размер в кусок помещается.
+            При успехе блок дальше освобождается уже с новым размером.
+            */
+            bool expand(char *p, std::size_t old_bytes, std::size_t new_bytes, std::size_t id = untyped)
             {
-                std::free(pbegin);
+                if (new_bytes > std::numeric_limits<size_t>::max() / 2)
+                    return false;
+                size_t old_size = class_size(size_class(old_bytes));
+                size_t new_size = class_size(size_class(new_bytes));
+                if (p + old_size != ptr || new_size > static_cast<size_t>(end - p))
+                    return false;
+                if (scopes)
+                {
+                    // Блок снаружи области нельзя растягивать за ее отметку
+                    if (!in_scope(*scopes, p))
+                        return false;
+                    scopes->live_bytes = scopes->live_bytes - old_size + new_size;
+                    scopes->resize(id, old_bytes, new_bytes);
+                }
+                ptr = p + new_size;
+                if (ptr > peak)
+                    peak = ptr;
+                counters.live_bytes = counters.live_bytes - old_size + new_size;
+                if (counters.live_bytes > counters.peak_bytes)
+                    counters.peak_bytes = counters.live_bytes;
+                return true;
+            }
+
+            /// Лимит и учет элементов типа с номером id, размещенных в этом блоке
+            quota<single_threaded> &account(size_t id)
+            {
+                if (id >= accounts.size())
+                    accounts.resize(id + 1);
+                return accounts[id];
+            }
+
+            /// Снимок статистики; на размещение и освобождение она не влияет
+            arena_stats stats() const
+            {
+                arena_stats result;
+                result.reserved = reserved();
+                result.chunks = chunks_count;
+                result.live_blocks = blocks;
+                result.live_bytes = counters.live_bytes;
+                result.peak_bytes = counters.peak_bytes;
+                result.allocations = counters.allocations;
+                result.deallocations = counters.deallocations;
+                result.failures = counters.failures;
+                result.free_list_bytes = counters.free_list_bytes;
+                result.chunk_tail_bytes = counters.chunk_tail_bytes;
+                for (size_t cls = 0; cls < size_classes; ++cls)
+                    if (counters.class_hits[cls])
+                        result.histogram.emplace_back(class_size(cls), counters.class_hits[cls]);
+                return result;
+            }
+
+            /// Количество кусков в цепочке
+            size_t chunks() const { return chunks_count; }
+
+            /// Суммарный объем памяти, полученной от системы
+            size_t reserved() const
+            {
+                size_t total = spare ? spare->size : 0;
+                for (chunk *c = head; c; c = c->prev)
+                    total += c->size;
+                return total;
+            }
+
+        private:
+            struct free_node
+            {
+                free_node *next;
+            };
+
+            struct chunk;
+
+            /// Деструктор объекта из create(); узлы лежат в том же блоке
+            struct finalizer
+            {
+                void (*destroy)(void *);
+                void *object;
+                finalizer *next;
+            };
+
+            /// Число объектов типа, размещенных в области, и размер объекта
+            struct scoped_type
+            {
+                long long objects = 0;
+                size_t bytes_per_obj = 0;
+            };
+
+            /**
+            Отметка arena_scope: положение выделения, отложенные списки
+            свободных блоков внешнего уровня и учет размещенного в области.
+            Области вложены, scopes указывает на самую внутреннюю.
+            */
+            struct scope_state
+            {
+                scope_state *outer = nullptr;
+                bool active = false;
+                chunk *head = nullptr;
+                char *ptr = nullptr;
+                char *peak = nullptr;
+                size_t next_size = 0;
+                size_t chunk_tail_bytes = 0;
+                finalizer *finalizers = nullptr;
+                free_node *stash[size_classes];
+                size_t stash_bytes = 0;
+                size_t live_blocks = 0;
+                size_t live_bytes = 0;
+                std::vector<scoped_type> types;
+
+                void count(size_t id, long long objects, size_t bytes_per_obj)
+                {
+                    if (id == untyped)
+                        return;
+                    if (id >= types.size())
+                        types.resize(id + 1);
+                    types[id].objects += objects;
+                    types[id].bytes_per_obj = bytes_per_obj;
+                }
+                void resize(size_t id, size_t old_bytes, size_t new_bytes)
+                {
+                    if (id < types.size() && types[id].bytes_per_obj)
+                        types[id].objects += (static_cast<long long>(new_bytes) - static_cast<long long>(old_bytes)) /
+                                             static_cast<long long>(types[id].bytes_per_obj);
+                }
+            };
+
+            /// Блок p размещен после отметки s: в ее куске за ptr или в более новом куске
+            bool in_scope(const scope_state &s, const char *p) const
+            {
+                auto addr = reinterpret_cast<std::uintptr_t>(p);
+                for (chunk *c = head; c != s.head; c = c->prev)
+                    if (addr > reinterpret_cast<std::uintptr_t>(c) &&
+                        addr < reinterpret_cast<std::uintptr_t>(c) + c->size)
+                        return true;
+                return addr >= reinterpret_cast<std::uintptr_t>(s.ptr) &&
+                       addr < reinterpret_cast<std::uintptr_t>(s.head) + s.head->size;
+            }
+
+            void enter_scope(scope_state &s)
+            {
+                s.outer = scopes;
+                s.active = true;
+                s.head = head;
+                s.ptr = ptr;
+                s.peak = peak;
+                s.next_size = next_size;
+                s.chunk_tail_bytes = counters.chunk_tail_bytes;
+                s.finalizers = finalizers;
+                std::copy(std::begin(free_heads), std::end(free_heads), std::begin(s.stash));
+                std::fill(std::begin(free_heads), std::end(free_heads), nullptr);
+                s.stash_bytes = counters.free_list_bytes;
+                for (scope_state *o = scopes; o; o = o->outer)
+                    s.stash_bytes -= o->stash_bytes;
+                scopes = &s;
+            }
+
+            /// Выход из области s и всех вложенных в нее, еще не закрытых
+            void leave_scope(scope_state &s)
+            {
+                while (s.active)
+                {
+                    scope_state &top = *scopes;
+                    run_finalizers(top.finalizers);
+                    if (head != top.head)
+                    {
+                        // Самый большой из кусков области остается запасным для следующей
+                        while (head != top.head)
+                        {
+                            chunk *prev = head->prev;
+                            if (!spare || head->size > spare->size)
+                                std::swap(head, spare);
+                            if (head)
+                                unmap_chunk(head);
+                            --chunks_count;
+                            head = prev;
+                        }
+                        end = reinterpret_cast<char *>(head) + head->size;
+                        peak = top.peak;
+                        next_size = top.next_size;
+                        counters.chunk_tail_bytes = top.chunk_tail_bytes;
+                    }
+                    ptr = top.ptr;
+                    std::copy(std::begin(top.stash), std::end(top.stash), std::begin(free_heads));
+                    counters.free_list_bytes = 0;
+                    for (scope_state *o = &top; o; o = o->outer)
+                        counters.free_list_bytes += o->stash_bytes;
+                    blocks -= top.live_blocks;
+                    counters.live_bytes -= top.live_bytes;
+                    counters.deallocations += top.live_blocks;
+                    for (size_t id = 0; id < top.types.size() && id < accounts.size(); ++id)
+                        accounts[id].total.add(-top.types[id].objects);
+                    top.active = false;
+                    scopes = top.outer;
+                }
+                if (blocks == 0 && !scopes)
+                    reset();
+            }
+
+            template <typename T, bool Finalize, typename... Args>
+            T *make(Args &&... args)
+            {
+                char *mem = place(1, sizeof(T), alignof(T));
+                T *obj = nullptr;
+                try
+                {
+                    obj = new (mem) T(std::forward<Args>(args)...);
+                }
+                catch (...)
+                {
+                    clean(mem, 1, sizeof(T));
+                    throw;
+                }
+                if constexpr (Finalize)
+                {
+                    char *node = nullptr;
+                    try
+                    {
+                        node = place(1, sizeof(finalizer), alignof(finalizer));
+                    }
+                    catch (...)
+                    {
+                        obj->~T();
+                        clean(mem, 1, sizeof(T));
+                        throw;
+                    }
+                    finalizers = new (node) finalizer{[](void *o) { static_cast<T *>(o)->~T(); }, obj, finalizers};
+                }
+                return obj;
+            }
+
+            /// Деструкторы объектов create(), созданных после узла last, в обратном порядке
+            void run_finalizers(finalizer *last)
+            {
+                while (finalizers != last)
+                {
+                    finalizer *f = finalizers;
+                    finalizers = f->next;
+                    f->destroy(f->object);
+                }
+            }
+
+            struct alignas(cache_line_alignment) chunk
+            {
+                chunk *prev;
+                size_t size;
+            };
+
+            static bool is_aligned(const void *p, size_t alignment)
+            {
+                return (reinterpret_cast<std::uintptr_t>(p) & (alignment - 1)) == 0;
+            }
+
+            static size_t padding(const char *p, size_t alignment)
+            {
+                return (alignment - (reinterpret_cast<std::uintptr_t>(p) & (alignment - 1))) &
+                       (alignment - 1);
+            }
+
+            /// Пропуск перед выровненным блоком становится свободным блоком своего класса
+            void keep_gap(char *p, size_t gap)
+            {
+                if (gap == 0 || gap > small_size_max)
+                    return;
+                size_t cls = size_class(gap);
+                auto node = reinterpret_cast<free_node *>(p);
+                node->next = free_heads[cls];
+                free_heads[cls] = node;
+                counters.free_list_bytes += gap;
+            }
+
+            void add_chunk(size_t min_bytes)
+            {
+                size_t size = std::max(next_size, min_bytes + sizeof(chunk));
+                chunk *c = nullptr;
+                if (spare && spare->size >= size)
+                {
+                    c = spare;
+                    spare = nullptr;
+                    size = c->size;
+                }
+                else
+                {
+                    try
+                    {
+                        c = static_cast<chunk *>(map_chunk(size));
+                    }
+                    catch (...)
+                    {
+                        ++counters.failures;
+                        throw;
+                    }
+                }
+                if (head)
+                    counters.chunk_tail_bytes += static_cast<size_t>(end - ptr);
+                c->prev = head;
+                c->size = size;
+                head = c;
+                ptr = reinterpret_cast<char *>(c + 1);
+                peak = ptr;
+                end = reinterpret_cast<char *>(c) + size;
+                ++chunks_count;
+                if (next_size <= std::numeric_limits<size_t>::max() / 2 / options.growth_factor)
+                    next_size *= options.growth_factor;
             }
 
-            char *place(std::size_t n, std::size_t bytes_per_obj)
+            /// Память под кусок; size округляется до строки кэша или страницы
+            void *map_chunk(size_t &size) const
             {
-#ifdef DEBUG
-                /*FOR DEBUG*/ std::cerr << '\n'
-                                        << "ptr before allocate =" << ptr << '\n';
+                size = (size + cache_line_alignment - 1) & ~(cache_line_alignment - 1);
+#if defined(SLVR_HAS_MMAP)
+                if (options.backing == backing_store::mmap)
+                {
+                    size_t page = options.huge_pages ? huge_page_size : page_size();
+                    size = (size + page - 1) & ~(page - 1);
+                    int flags = MAP_PRIVATE | MAP_ANONYMOUS;
+#if defined(MAP_POPULATE)
+                    if (options.prefault)
+                        flags |= MAP_POPULATE;
 #endif
-                if (n * bytes_per_obj > sizeofblock - ptr)
-                    throw std::bad_alloc();
-                auto p = reinterpret_cast<char *>(pbegin) + ptr;
-                ptr += n * bytes_per_obj;
-#ifdef DEBUG
-                /*FOR DEBUG*/ std::cerr << '\n'
-                                        << "ptr after allocate =" << ptr << '\n'
-                                        << std::endl;
+                    void *p = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, flags, -1, 0);
+                    if (p == MAP_FAILED)
+                        throw std::bad_alloc();
+#if defined(MADV_HUGEPAGE)
+                    if (options.huge_pages)
+                        ::madvise(p, size, MADV_HUGEPAGE);
+#endif
+                    return p;
+                }
 #endif
+                void *p = std::aligned_alloc(cache_line_alignment, size);
+                if (!p)
+                    throw std::bad_alloc();
                 return p;
             }
 
-            void clean(char *p, std::size_t n, std::size_t bytes_per_obj)
-            {
-#ifdef DEBUG
-                    std::cerr << "from clean before ptr = " << ptr << '\n';
-                    std::cerr << "from clean before used = " << used << '\n';
-#endif                
-                char *end_of_object = p + n * bytes_per_obj;
-                char *end_of_allocated_block = reinterpret_cast<char *>(pbegin) + ptr;
-                if (end_of_object == end_of_allocated_block)
-                    ptr = ptr - n * bytes_per_obj;
-                if (used == 0)
-                    ptr = 0;
-#ifdef DEBUG
-                    std::cerr << "from clean after ptr = " << ptr << '\n';
-                    std::cerr << "from clean after used = " << used << '\n';
-#endif                     
-                return;
+            void unmap_chunk(chunk *c) const
+            {
+#if defined(SLVR_HAS_MMAP)
+                if (options.backing == backing_store::mmap)
+                {
+                    ::munmap(c, c->size);
+                    return;
+                }
+#endif
+                std::free(c);
+            }
+
+            /**
+            Страницы куска c, использованные дальше retain_bytes от начала, 
+            отдаются системе. Сброс блока, не выходившего за retain_bytes 
+            (короткий цикл размещений), обходится без системного вызова; с 
+            большими страницами граница кратна huge_page_size, чтобы их не дробить.
+            */
+            void trim_chunk(chunk *c) const
+            {
+#if defined(SLVR_HAS_MMAP) && defined(MADV_DONTNEED)
+                if (options.backing != backing_store::mmap)
+                    return;
+                auto page = static_cast<std::uintptr_t>(options.huge_pages ? huge_page_size : page_size());
+                auto from = (reinterpret_cast<std::uintptr_t>(c + 1) + options.retain_bytes + page - 1) & ~(page - 1);
+                auto to = std::min((reinterpret_cast<std::uintptr_t>(peak) + page - 1) & ~(page - 1),
+                                   reinterpret_cast<std::uintptr_t>(c) + c->size);
+                if (to > from)
+                    ::madvise(reinterpret_cast<void *>(from), to - from, MADV_DONTNEED);
+#else
+                (void)c;
+#endif
+            }
+
+            static size_t page_size()
+            {
+#if defined(SLVR_HAS_MMAP)
+                static const size_t size = static_cast<size_t>(::sysconf(_SC_PAGESIZE));
+                return size;
+#else
+                return 4096;
+#endif
+            }
+
+            static constexpr size_t huge_page_size = 2 * 1024 * 1024;
+
+            void release_chunks()
+            {
+                if (spare)
+                    unmap_chunk(spare);
+                spare = nullptr;
+                chunk *c = head;
+                while (c)
+                {
+                    chunk *prev = c->prev;
+                    unmap_chunk(c);
+                    --chunks_count;
+                    c = prev;
+                }
+            }
+
+            /// Все блоки освобождены: остается только последний, самый большой кусок
+            void reset()
+            {
+                chunk *older = head->prev;
+                head->prev = nullptr;
+                while (older)
+                {
+                    chunk *prev = older->prev;
+                    unmap_chunk(older);
+                    --chunks_count;
+                    older = prev;
+                }
+                trim_chunk(head);
+                ptr = reinterpret_cast<char *>(head + 1);
+                peak = ptr;
+                std::fill(std::begin(free_heads), std::end(free_heads), nullptr);
+                counters.free_list_bytes = 0;
+                counters.chunk_tail_bytes = 0;
+            }
+
+            arena_options options;
+            chunk *head;
+            char *ptr;
+            char *end;
+            char *peak;
+            size_t next_size;
+            size_t blocks;
+            size_t chunks_count;
+            free_node *free_heads[size_classes];
+            std::vector<quota<single_threaded>> accounts;
+            scope_state *scopes = nullptr;
+            finalizer *finalizers = nullptr;
+            /// Кусок, освобожденный выходом из области и ждущий повторного использования
+            chunk *spare = nullptr;
+
+            struct arena_counters
+            {
+                size_t live_bytes = 0;
+                size_t peak_bytes = 0;
+                size_t allocations = 0;
+                size_t deallocations = 0;
+                size_t failures = 0;
+                size_t free_list_bytes = 0;
+                size_t chunk_tail_bytes = 0;
+                size_t class_hits[size_classes] = {};
+            } counters;
+        };
+
+        inline slvr::allocator::membuf buffer{};
+
+        /**
+        Блок памяти потока для режима concurrent.
+        Владелец размещает и освобождает память без блокировок через свой membuf.
+        Блок, освобожденный другим потоком, кладется в lock-free стек 
+        remote_head владельца и возвращается в списки свободных блоков при 
+        следующем размещении владельцем. Перед каждым объектом хранится заголовок 
+        с указателем на владельца и размером блока. Счетчик refs учитывает живые блоки и сам 
+        поток-владелец: блок памяти потока удаляется, когда поток завершился и 
+        освобожден последний его блок.
+        */
+        class thread_membuf
+        {
+        public:
+            thread_membuf(const thread_membuf &) = delete;
+            thread_membuf &operator=(const thread_membuf &) = delete;
+
+            static thread_membuf &local()
+            {
+                thread_local holder h{};
+                return *h.arena;
+            }
+
+            char *place(std::size_t n, std::size_t bytes_per_obj, std::size_t alignment)
+            {
+                if (remote_head.load(std::memory_order_relaxed))
+                    drain();
+                if (bytes_per_obj != 0 &&
+                    n > (std::numeric_limits<size_t>::max() / 4) / bytes_per_obj)
+                    throw std::bad_alloc();
+                size_t prefix = prefix_size(alignment);
+                size_t bytes = n * bytes_per_obj + prefix;
+                char *block = arena.place(1, bytes, alignment);
+                auto h = reinterpret_cast<header *>(block + prefix) - 1;
+                h->owner = this;
+                h->bytes = bytes;
+                refs.fetch_add(1, std::memory_order_relaxed);
+                return block + prefix;
             }
 
-            void construct()
+            /// Изменение размера на месте; блоки других потоков не расширяются
+            static bool expand(char *p, std::size_t old_bytes, std::size_t new_bytes,
+                               std::size_t alignment)
             {
-                used++;
+                auto h = reinterpret_cast<header *>(p) - 1;
+                thread_membuf *owner = h->owner;
+                if (owner != self() || new_bytes > std::numeric_limits<size_t>::max() / 4)
+                    return false;
+                size_t prefix = prefix_size(alignment);
+                if (h->bytes != old_bytes + prefix ||
+                    !owner->arena.expand(p - prefix, h->bytes, new_bytes + prefix))
+                    return false;
+                h->bytes = new_bytes + prefix;
+                return true;
             }
 
-            void destroy()
+            static void release(char *p, std::size_t alignment)
             {
-                used--;
-#ifdef DEBUG
-                std::cerr << "from massive::destroy used = " << used << '\n';
-#endif                
+                auto h = reinterpret_cast<header *>(p) - 1;
+                thread_membuf *owner = h->owner;
+                size_t bytes = h->bytes;
+                char *block = p - prefix_size(alignment);
+                if (owner == self())
+                {
+                    owner->arena.clean(block, 1, bytes);
+                    owner->refs.fetch_sub(1, std::memory_order_relaxed);
+                    return;
+                }
+                auto node = reinterpret_cast<remote_node *>(block);
+                node->bytes = bytes;
+                node->next = owner->remote_head.load(std::memory_order_relaxed);
+                while (!owner->remote_head.compare_exchange_weak(node->next, node,
+                                                                 std::memory_order_release,
+                                                                 std::memory_order_relaxed))
+                    ;
+                if (owner->refs.fetch_sub(1, std::memory_order_acq_rel) == 1)
+                    delete owner;
             }
 
         private:
-            void *pbegin;
-            size_t begin;
-            size_t end;
-            size_t ptr;
-            size_t used;
+            struct header
+            {
+                thread_membuf *owner;
+                size_t bytes;
+            };
+
+            struct remote_node
+            {
+                remote_node *next;
+                size_t bytes;
+            };
+
+            struct holder
+            {
+                thread_membuf *arena;
+                holder() : arena(new thread_membuf()) { self() = arena; }
+                ~holder()
+                {
+                    self() = nullptr;
+                    arena->drain();
+                    if (arena->refs.fetch_sub(1, std::memory_order_acq_rel) == 1)
+                        delete arena;
+                }
+            };
+
+            thread_membuf() : remote_head(nullptr), refs(1) {}
+
+            /// Заголовок лежит вплотную перед объектом, начало блока выровнено как объект
+            static size_t prefix_size(size_t alignment)
+            {
+                return std::max(alignment, sizeof(header));
+            }
+
+            static thread_membuf *&self()
+            {
+                thread_local thread_membuf *current = nullptr;
+                return current;
+            }
+
+            void drain()
+            {
+                auto node = remote_head.exchange(nullptr, std::memory_order_acquire);
+                while (node)
+                {
+                    auto next = node->next;
+                    arena.clean(reinterpret_cast<char *>(node), 1, node->bytes);
+                    node = next;
+                }
+            }
+
+            membuf arena;
+            std::atomic<remote_node *> remote_head;
+            std::atomic<size_t> refs;
         };
 
-        static slvr::allocator::membuf buffer{};
+        /**
+        Ссылка superK на блок памяти. В режиме single_threaded это общий 
+        блок buffer либо собственный блок контейнера: внешний membuf или 
+        membuf во владении аллокатора, который освобождается целиком вместе 
+        с последней копией аллокатора. Аллокаторы равны, если ссылаются на 
+        один блок.
+        */
+        template <typename Mode>
+        class arena_ref
+        {
+        public:
+            using is_always_equal = std::false_type;
 
-        template <typename T>
+            arena_ref() noexcept : m_arena(&buffer) {}
+            explicit arena_ref(membuf &arena) noexcept : m_arena(&arena) {}
+            explicit arena_ref(std::shared_ptr<membuf> arena)
+                : m_arena(arena.get()), m_owner(std::move(arena))
+            {
+                if (!m_arena)
+                    throw std::invalid_argument("superK needs a memory block");
+            }
+
+            char *place(std::size_t n, std::size_t bytes_per_obj, std::size_t alignment, std::size_t id) const
+            {
+                return m_arena->place(n, bytes_per_obj, alignment, id);
+            }
+            void clean(char *p, std::size_t n, std::size_t bytes_per_obj, std::size_t, std::size_t id) const
+            {
+                m_arena->clean(p, n, bytes_per_obj, id);
+            }
+            bool expand(char *p, std::size_t old_bytes, std::size_t new_bytes, std::size_t, std::size_t id) const
+            {
+                return m_arena->expand(p, old_bytes, new_bytes, id);
+            }
+
+            template <typename T>
+            quota<Mode> &account() const { return m_arena->account(type_id<T>()); }
+
+            membuf *get() const noexcept { return m_arena; }
+            bool operator==(const arena_ref &other) const noexcept { return m_arena == other.m_arena; }
+
+        private:
+            membuf *m_arena;
+            std::shared_ptr<membuf> m_owner;
+        };
+
+        template <>
+        class arena_ref<concurrent>
+        {
+        public:
+            using is_always_equal = std::true_type;
+
+            char *place(std::size_t n, std::size_t bytes_per_obj, std::size_t alignment, std::size_t) const
+            {
+                return thread_membuf::local().place(n, bytes_per_obj, alignment);
+            }
+            void clean(char *p, std::size_t, std::size_t, std::size_t alignment, std::size_t) const
+            {
+                thread_membuf::release(p, alignment);
+            }
+            bool expand(char *p, std::size_t old_bytes, std::size_t new_bytes,
+                        std::size_t alignment, std::size_t) const
+            {
+                return thread_membuf::expand(p, old_bytes, new_bytes, alignment);
+            }
+
+            template <typename T>
+            quota<concurrent> &account() const
+            {
+                static quota<concurrent> q{};
+                return q;
+            }
+
+            bool operator==(const arena_ref &) const noexcept { return true; }
+        };
+
+        template <typename T, typename Mode = single_threaded>
         struct superK
         {
 
@@ -122,60 +1061,55 @@ namespace slvr
             using size_type = std::size_t;
             using difference_type = std::ptrdiff_t;
 
+            using propagate_on_container_copy_assignment = std::false_type;
+            using propagate_on_container_move_assignment = std::true_type;
+            using propagate_on_container_swap = std::true_type;
+            using is_always_equal = typename arena_ref<Mode>::is_always_equal;
+
             template <typename U>
             struct rebind
             {
-                using other = superK<U>;
+                using other = superK<U, Mode>;
             };
 
             superK() = default;
             ~superK() = default;
-            superK(const superK &) {}
+            superK(const superK &) = default;
+            superK &operator=(const superK &) = default;
+
+            /// Аллокатор, размещающий объекты во внешнем блоке arena
+            explicit superK(membuf &arena) : m_arena(arena) {}
+
+            /// Аллокатор, владеющий блоком arena совместно со своими копиями
+            explicit superK(std::shared_ptr<membuf> arena) : m_arena(std::move(arena)) {}
 
             template <typename U>
-            superK(const superK<U> &) {}
+            superK(const superK<U, Mode> &other) : m_arena(other.get_arena()) {}
+
+            /// Аллокатор с собственным блоком памяти, например для одного контейнера
+            static superK make_private(const arena_options &opts = arena_options{})
+            {
+                return superK(std::make_shared<membuf>(opts));
+            }
+
+            const arena_ref<Mode> &get_arena() const { return m_arena; }
 
         private:
-            static size_t manage_max_n(size_t max_n = 0)
+            static size_t default_max_n()
             {
-                static size_t m_max_n =
-                    std::min<size_t>(std::numeric_limits<size_type>::max(), sizeofblock) / sizeof(T);
-#ifdef DEBUG
-                std::cerr << "manage_max_n before = " << m_max_n << '\n';
-#endif
+                return std::numeric_limits<size_type>::max() / sizeof(T);
+            }
+            size_t manage_max_n(size_t max_n = 0) const
+            {
+                auto &m_max_n = m_arena.template account<T>().max_n;
                 if (max_n == 0)
-                {
-#ifdef DEBUG
-                    std::cerr << "manage_max_n after = " << m_max_n << '\n';
-#endif
-                    return m_max_n;
-                }
-                if (max_n == sizeofblock)
-                {
-#ifdef DEBUG
-                    std::cerr << "manage_max_n after = " << m_max_n << '\n';
-#endif
-                    m_max_n = std::min<size_t>(std::numeric_limits<size_type>::max(), sizeofblock)/sizeof(T);
-                    return m_max_n;
-                }
-                m_max_n = max_n;
-#ifdef DEBUG
-                std::cerr << "manage_max_n after = " << m_max_n << '\n';
-#endif
-                return m_max_n;
+                    return m_max_n.load() ? m_max_n.load() : default_max_n();
+                m_max_n.store(max_n);
+                return m_max_n.load();
             }
-            static signed long long total_allocated(signed long long alloc_change = 0)
+            signed long long total_allocated() const
             {
-                static signed long long m_total_allocated = 0;
-#ifdef DEBUG
-                std::cerr << "total_allocated and alloc_change before = " << m_total_allocated << " " << alloc_change << '\n';
-#endif
-                if (alloc_change == 0)
-                    return m_total_allocated;
-                m_total_allocated += alloc_change;
-                if (m_total_allocated < 0)
-                    throw std::domain_error("Too many deallocation by allocator of type superK");
-                return m_total_allocated;
+                return m_arena.template account<T>().total.load();
             }
 
         public:
@@ -183,55 +1117,226 @@ namespace slvr
             {
                 if (n == 0)
                     {
-                        manage_max_n(sizeofblock);
+                        manage_max_n(default_max_n());
                         return;
                     }
-                if (n > sizeofblock / sizeof(T) ||
+                if (n > default_max_n() ||
                     n < static_cast<size_t>(total_allocated()))
                     throw std::domain_error("cannot set limits to allocator superK");
                 manage_max_n(n);
                 return;
             }
             size_t get_limit() const { return manage_max_n(); }
+
+            /**
+            Выравнивание объектов типа T в блоке памяти, не меньше alignof(T).
+            Например cache_line_alignment исключает ложное разделение строк кэша,
+            а simd_alignment позволяет читать буфер выровненными загрузками AVX.
+            Менять можно только пока объекты этого типа не размещены.
+            */
+            void set_alignment(size_t alignment)
+            {
+                if (alignment & (alignment - 1))
+                    throw std::domain_error("alignment of allocator superK must be a power of two");
+                if (total_allocated() != 0)
+                    throw std::domain_error("cannot change alignment of allocator superK in use");
+                m_arena.template account<T>().align.store(alignment);
+            }
+            size_t get_alignment() const
+            {
+                return std::max(alignof(T), m_arena.template account<T>().align.load());
+            }
             size_type max_size() const
             {
-                size_t maximum = sizeofblock / sizeof(T);
-                if (manage_max_n() != 0)
-                    maximum = manage_max_n();
-                return maximum;
+                return manage_max_n();
             }
 
             T *allocate(std::size_t n)
             {
-                if (n * sizeof(T) > sizeofblock ||
-                    static_cast<size_t>(total_allocated()) + n > manage_max_n())
+                auto &acc = m_arena.template account<T>();
+                if (n > default_max_n())
+                {
+                    acc.failures.add(1);
+                    trace::emit<T>(trace::kind::failure, n, nullptr);
+                    throw std::bad_alloc();
+                }
+                auto change = static_cast<signed long long>(n);
+                auto total = acc.total.add(change);
+                size_t limit = acc.max_n.load();
+                if (limit != 0 && static_cast<size_t>(total) > limit)
+                {
+                    acc.total.add(-change);
+                    acc.failures.add(1);
+                    trace::emit<T>(trace::kind::failure, n, nullptr);
                     throw std::bad_alloc();
-                auto p = buffer.place(n, sizeof(T));
-                total_allocated(n);
+                }
+                char *p = nullptr;
+                const size_t alignment = std::max(alignof(T), acc.align.load());
+                try
+                {
+                    p = m_arena.place(n, sizeof(T), alignment, type_id<T>());
+                }
+                catch (...)
+                {
+                    acc.total.add(-change);
+                    acc.failures.add(1);
+                    trace::emit<T>(trace::kind::failure, n, nullptr);
+                    throw;
+                }
+                acc.allocations.add(1);
+                acc.peak.raise(total);
+                trace::emit<T>(trace::kind::allocate, n, p, 0, alignment);
                 return reinterpret_cast<T *>(p);
             }
 
             void deallocate(T *p, std::size_t n)
             {
-                
-                
-                buffer.clean(reinterpret_cast<char *>(p), n, sizeof(T));
-                total_allocated(-static_cast<signed long long>(n));
+                auto &acc = m_arena.template account<T>();
+                const size_t alignment = std::max(alignof(T), acc.align.load());
+                trace::emit<T>(trace::kind::deallocate, n, p, 0, alignment);
+                m_arena.clean(reinterpret_cast<char *>(p), n, sizeof(T), alignment, type_id<T>());
+                if (acc.total.add(-static_cast<signed long long>(n)) < 0)
+                    throw std::domain_error("Too many deallocation by allocator of type superK");
+            }
+
+            /**
+            Попытка изменить размер массива p с old_n до new_n элементов без 
+            перемещения. Удается, если массив - последний размещенный блок 
+            и место в текущем куске есть; иначе возвращается false и ничего
+            не меняется. Контейнер massive использует ее при росте.
+            */
+            bool try_expand(T *p, std::size_t old_n, std::size_t new_n)
+            {
+                auto &acc = m_arena.template account<T>();
+                if (new_n > default_max_n())
+                    return false;
+                auto change = static_cast<signed long long>(new_n) - static_cast<signed long long>(old_n);
+                auto total = acc.total.add(change);
+                size_t limit = acc.max_n.load();
+                const size_t alignment = std::max(alignof(T), acc.align.load());
+                if ((limit != 0 && static_cast<size_t>(total) > limit) ||
+                    !m_arena.expand(reinterpret_cast<char *>(p), old_n * sizeof(T), new_n * sizeof(T), alignment,
+                                    type_id<T>()))
+                {
+                    acc.total.add(-change);
+                    return false;
+                }
+                acc.peak.raise(total);
+                trace::emit<T>(trace::kind::expand, new_n, p, old_n, alignment);
+                return true;
+            }
+
+            /// Снимок статистики по типу T в блоке памяти этого аллокатора
+            type_stats stats() const
+            {
+                auto &acc = m_arena.template account<T>();
+                type_stats result;
+                result.live_objects = static_cast<size_t>(acc.total.load());
+                result.live_bytes = result.live_objects * sizeof(T);
+                result.peak_objects = static_cast<size_t>(acc.peak.load());
+                result.peak_bytes = result.peak_objects * sizeof(T);
+                result.allocations = acc.allocations.load();
+                result.failures = acc.failures.load();
+                result.limit = get_limit();
+                result.alignment = get_alignment();
+                return result;
             }
 
             template <typename U, typename... Args>
             void construct(U *p, Args &&... args)
             {
                 new (p) U(std::forward<Args>(args)...);
-                buffer.construct();
+                trace::emit<U>(trace::kind::construct, 1, p);
             }
 
             template <typename U>
             void destroy(U *p)
             {
+                trace::emit<U>(trace::kind::destroy, 1, p);
                 p->~U();
-                buffer.destroy();
             }
+
+        private:
+            arena_ref<Mode> m_arena;
+        };
+
+        template <typename T, typename U, typename Mode>
+        bool operator==(const superK<T, Mode> &a, const superK<U, Mode> &b) noexcept
+        {
+            return a.get_arena() == b.get_arena();
+        }
+
+        template <typename T, typename U, typename Mode>
+        bool operator!=(const superK<T, Mode> &a, const superK<U, Mode> &b) noexcept
+        {
+            return !(a == b);
+        }
+
+        /**
+        Область жизни данных в блоке membuf, например на время обработки
+        одного запроса. При создании запоминается положение выделения, при
+        выходе из области (или release()) все, что размещено в блоке после
+        этого, освобождается разом: ptr возвращается к отметке, добавленные
+        куски отдаются системе, учет superK по типам уменьшается на
+        неосвобожденное. Поэлементные destroy и deallocate не нужны, для
+        тривиально разрушаемых объектов выход из области - O(1) по числу
+        объектов. Деструкторы вызываются только для объектов create() с
+        нетривиальным деструктором. Блоки, освобожденные в области, 
+        переиспользуются только в ней; списки свободных блоков внешнего 
+        уровня откладываются и восстанавливаются при выходе. Области 
+        вкладываются; выход из внешней закрывает и вложенные. Контейнеры, 
+        размещенные в области, не должны использоваться после выхода из нее.
+        */
+        class arena_scope
+        {
+        public:
+            explicit arena_scope(membuf &arena = buffer) : m_arena(&arena) { m_arena->enter_scope(m_state); }
+
+            /// Область в блоке памяти аллокатора alloc
+            template <typename T>
+            explicit arena_scope(const superK<T> &alloc) : arena_scope(*alloc.get_arena().get())
+            {
+            }
+
+            ~arena_scope() { release(); }
+
+            arena_scope(const arena_scope &) = delete;
+            arena_scope &operator=(const arena_scope &) = delete;
+
+            /// Досрочный выход из области; повторный вызов ничего не делает
+            void release()
+            {
+                if (m_state.active)
+                    m_arena->leave_scope(m_state);
+            }
+
+            bool active() const noexcept { return m_state.active; }
+            membuf &arena() const noexcept { return *m_arena; }
+
+            /// Блоки, размещенные в области и еще не освобожденные
+            size_t live_blocks() const noexcept { return m_state.live_blocks; }
+
+            /// Объект T, разрушаемый при выходе из области
+            template <typename T, typename... Args>
+            T *create(Args &&... args)
+            {
+                if (!m_state.active)
+                    throw std::logic_error("arena_scope is already released");
+                return m_arena->template create<T>(std::forward<Args>(args)...);
+            }
+
+            /// Объект T без вызова деструктора (membuf::create_unmanaged())
+            template <typename T, typename... Args>
+            T *create_unmanaged(Args &&... args)
+            {
+                if (!m_state.active)
+                    throw std::logic_error("arena_scope is already released");
+                return m_arena->template create_unmanaged<T>(std::forward<Args>(args)...);
+            }
+
+        private:
+            membuf *m_arena;
+            membuf::scope_state m_state;
         };
 
     } // namespace allocator
@@ -3,18 +3,43 @@
 \brief Определение класса container::massive
 
 Заголовочный файл с определением класса container::massive. 
-Контейнер позволяет записывать и хранить целочисленные данные.
-Размещение памяти для контейнера типа massive может определяться
-постоянными min_reserve-минимальный резерв памяти для контейнера
-и step_koef - шаг-множитель наращивания памяти. 
+Контейнер хранит элементы любого типа: числа, POD-структуры, типы
+только с перемещением (std::unique_ptr). При переносе в новый буфер
+тривиально переносимые элементы (is_trivially_relocatable) копируются
+одним memcpy, остальные перемещаются (std::move_if_noexcept); элементы
+с тривиальным деструктором не разрушаются поштучно.
+Элементы лежат в непрерывной памяти (data()), итераторы - произвольного
+доступа, поэтому std::sort, std::lower_bound и другие алгоритмы 
+работают с massive так же, как с обычным массивом.
+Размещение памяти для контейнера типа massive определяется политикой
+емкости (growth_policy): минимальный резерв, множитель наращивания 
+памяти и гистерезис ее возврата при уменьшении размера. Если аллокатор
+умеет менять размер блока на месте (try_expand, как superK), 
+память наращивается без копирования элементов.
+massive<T, A, N> с N > 0 держит до N элементов во встроенном буфере
+и не обращается к аллокатору, пока они в нем помещаются.
+Сумма, минимум, максимум, подсчет, поиск и гистограмма (sum(), min(),
+max(), count(), find(), contains(), histogram()) считаются векторными
+ядрами из slvr_container_simd.h и есть только у целочисленных massive. Большие массивы можно обрабатывать
+параллельно (parallel_for_each(), parallel_transform(), parallel_reduce(),
+parallel_sort()) на пуле потоков из slvr_thread_pool.h.
 */
 #ifndef SLVR_CONTAINER_H_
 #define SLVR_CONTAINER_H_
 
+#include <algorithm>
+#include <cstring>
 #include <functional>
 #include <iterator>
 #include <memory>
 #include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "slvr_container_simd.h"
+#include "slvr_thread_pool.h"
+#include "slvr_trace.h"
 
 namespace slvr
 {
@@ -22,18 +47,126 @@ namespace slvr
     namespace container
     {
 
+        /// Признак аллокатора, умеющего менять размер блока на месте (try_expand)
+        template <typename A, typename = void>
+        struct has_try_expand : std::false_type
+        {
+        };
+
+        template <typename A>
+        struct has_try_expand<A, std::void_t<decltype(std::declval<A &>().try_expand(
+                                     std::declval<typename A::value_type *>(), size_t(), size_t()))>>
+            : std::true_type
+        {
+        };
+
+        /**
+        Признак типа, который можно перенести в другую память копированием
+        байт, без конструктора перемещения и деструктора исходного объекта.
+        По умолчанию - тривиально копируемые типы; для своих типов без
+        указателей на самих себя признак можно специализировать.
+        */
+        template <typename T>
+        struct is_trivially_relocatable : std::is_trivially_copyable<T>
+        {
+        };
+
+        /// Место под N элементов внутри объекта massive; при N = 0 ничего не занимает
+        template <typename T, size_t N>
+        struct inline_buffer
+        {
+            alignas(T) unsigned char m_inline[N * sizeof(T)];
+            T *inline_data() noexcept { return reinterpret_cast<T *>(m_inline); }
+            const T *inline_data() const noexcept { return reinterpret_cast<const T *>(m_inline); }
+        };
+
+        template <typename T>
+        struct inline_buffer<T, 0>
+        {
+            T *inline_data() noexcept { return nullptr; }
+            const T *inline_data() const noexcept { return nullptr; }
+        };
+
+        /**
+        Политика емкости massive, выбираемая при компиляции. 
+        Емкость растет в GrowNum/GrowDen раза (минимум на элемент), начальный
+        резерв - MinReserve. После уменьшения размера емкость ужимается, 
+        только если превышает размер больше чем в ShrinkRatio раз (0 - не
+        ужимается никогда), и становится размером с запасом на шаг роста,
+        поэтому чередование добавления и удаления не гоняет память туда-обратно.
+        */
+        template <size_t GrowNum, size_t GrowDen, size_t MinReserve, size_t ShrinkRatio>
+        struct growth_policy
+        {
+            static_assert(GrowDen > 0 && GrowNum > GrowDen, "growth factor must be greater than 1");
+            static_assert(ShrinkRatio == 0 || ShrinkRatio * GrowDen > GrowNum,
+                          "shrink ratio must exceed growth factor");
+
+            static constexpr size_t min_reserve = MinReserve;
+
+            /// Емкость не меньше required при нехватке места, не больше max_size
+            static size_t grow(size_t capacity, size_t required, size_t max_size)
+            {
+                size_t next = capacity > max_size / GrowNum * GrowDen ? max_size : scale(capacity);
+                next = std::max({next, capacity + 1, required, min_reserve});
+                return std::min(next, max_size);
+            }
+
+            /// Емкость после уменьшения размера до size
+            static size_t shrink(size_t capacity, size_t size)
+            {
+                if (ShrinkRatio == 0 || capacity / ShrinkRatio <= std::max(size, min_reserve))
+                    return capacity;
+                return std::max(scale(size), min_reserve);
+            }
+
+        private:
+            static size_t scale(size_t n)
+            {
+                return n / GrowDen * GrowNum + n % GrowDen * GrowNum / GrowDen;
+            }
+        };
+
+        /// Рост втрое, как было изначально
+        using classic_growth = growth_policy<3, 1, 10, 4>;
+        /// Рост вдвое
+        using double_growth = growth_policy<2, 1, 8, 4>;
+        /// Рост в 1.5 раза: меньше лишней памяти, больше копирований
+        using compact_growth = growth_policy<3, 2, 4, 3>;
+        /// Рост вдвое, емкость при уменьшении размера не возвращается
+        using sticky_growth = growth_policy<2, 1, 8, 0>;
+
+        /**
+        Массив элементов T. N > 0 - первые N элементов хранятся в самом 
+        объекте: конструктор не обращается к аллокатору, память выделяется
+        только при переполнении встроенного буфера. Если после уменьшения 
+        размера политика емкости ужимает буфер до N и меньше, элементы 
+        возвращаются во встроенный буфер.
+        */
         template <typename T,
                   typename A = std::allocator<T>,
-                  typename = std::enable_if_t<std::is_integral<T>::value>>
-        class massive
+                  size_t N = 0,
+                  typename Policy = classic_growth>
+        class massive : private inline_buffer<T, N>
         {
         public:
             using value_type = T;
             using pointer = T *;
+            using const_pointer = const T *;
             using reference = T &;
+            using const_reference = const T &;
+            using size_type = std::size_t;
+            using difference_type = std::ptrdiff_t;
             using allocator_type = A ;
-            static const int min_reserve = 10;
-            static const int step_koef = 3;
+            using alloc_traits = std::allocator_traits<A>;
+            using policy_type = Policy;
+            static constexpr size_t min_reserve = Policy::min_reserve;
+            static constexpr size_t inline_capacity = N;
+
+        private:
+            /// Перенос из встроенного буфера при перемещении massive не бросает исключений
+            static constexpr bool nothrow_steal =
+                N == 0 || is_trivially_relocatable<T>::value || std::is_nothrow_move_constructible<T>::value;
 
         protected:
             T *start;
@@ -46,13 +179,24 @@ namespace slvr
             {
                 return this->m_alloc;
             }
+            const allocator_type &get_allocator() const
+            {
+                return this->m_alloc;
+            }
         private:
+            bool is_inline() const noexcept
+            {
+                return N > 0 && start == this->inline_data();
+            }
             void init_storage()
             {
-#ifdef DEBUG
-                std::cerr << "allocate from massive::init_storage()" << '\n';
-#endif
-                start = m_alloc.allocate(min_reserve);
+                if constexpr (N > 0)
+                {
+                    start = finish = this->inline_data();
+                    end_of_storage = start + N;
+                    return;
+                }
+                start = alloc_traits::allocate(m_alloc, min_reserve);
                 if (start == 0)
                     throw std::bad_alloc();
                 finish = start;
@@ -67,32 +211,146 @@ namespace slvr
                 init_storage();
             }
 
+            explicit massive(const allocator_type &alloc)
+                : start(), finish(), end_of_storage(), m_alloc(alloc)
+            {
+                init_storage();
+            }
+
+            massive(const massive &other)
+                : start(), finish(), end_of_storage(),
+                  m_alloc(alloc_traits::select_on_container_copy_construction(other.m_alloc))
+            {
+                init_storage();
+                try
+                {
+                    append(other.begin(), other.end());
+                }
+                catch (...)
+                {
+                    release_storage();
+                    throw;
+                }
+            }
+
+            /// Буфер в куче забирается, элементы встроенного буфера переносятся
+            massive(massive &&other) noexcept(nothrow_steal)
+                : start(), finish(), end_of_storage(), m_alloc(std::move(other.m_alloc))
+            {
+                steal(other);
+            }
+
+            massive &operator=(const massive &other)
+            {
+                if (this != &other)
+                {
+                    resize(0);
+                    append(other.begin(), other.end());
+                }
+                return *this;
+            }
+
+            massive &operator=(massive &&other) noexcept((alloc_traits::propagate_on_container_move_assignment::value ||
+                                                          alloc_traits::is_always_equal::value) &&
+                                                         nothrow_steal)
+            {
+                if (this == &other)
+                    return *this;
+                if (alloc_traits::propagate_on_container_move_assignment::value || m_alloc == other.m_alloc)
+                {
+                    release_storage();
+                    if constexpr (alloc_traits::propagate_on_container_move_assignment::value)
+                        m_alloc = std::move(other.m_alloc);
+                    steal(other);
+                }
+                else
+                {
+                    // Аллокаторы разные: память не забрать, элементы перемещаются по одному
+                    resize(0);
+                    append(std::make_move_iterator(other.begin()), std::make_move_iterator(other.end()));
+                    other.resize(0);
+                }
+                return *this;
+            }
+
             ~massive()
             {
-                for (pointer it = finish; it != start; --it)
-                    m_alloc.destroy(it - 1);
-                m_alloc.deallocate(start, static_cast<size_t>(end_of_storage - start));
+                release_storage();
             }
-            class iterator : public std::iterator<std::bidirectional_iterator_tag, T, T, const T *, T>
+            /**
+            Итератор произвольного доступа по непрерывной памяти massive.
+            Const=true - константный итератор; из обычного итератора 
+            он получается неявным преобразованием.
+            */
+            template <bool Const>
+            class basic_iterator
             {
             public:
-                T *iter = nullptr;
-                explicit iterator(T *num = 0) : iter(num) {}
-                iterator &operator++()
+                using iterator_category = std::random_access_iterator_tag;
+#if __cplusplus > 201703L
+                using iterator_concept = std::contiguous_iterator_tag;
+#endif
+                using value_type = T;
+                using difference_type = std::ptrdiff_t;
+                using pointer = std::conditional_t<Const, const T *, T *>;
+                using reference = std::conditional_t<Const, const T &, T &>;
+
+                pointer iter = nullptr;
+                basic_iterator() = default;
+                explicit basic_iterator(pointer num) : iter(num) {}
+                operator basic_iterator<true>() const { return basic_iterator<true>(iter); }
+
+                reference operator*() const { return *iter; }
+                pointer operator->() const { return iter; }
+                reference operator[](difference_type n) const { return iter[n]; }
+
+                basic_iterator &operator++()
                 {
                     ++iter;
                     return *this;
                 }
-                iterator &operator--()
+                basic_iterator &operator--()
                 {
                     --iter;
                     return *this;
                 }
-                bool operator==(iterator other) const { return iter == other.iter; }
-                bool operator!=(iterator other) const { return !(*this == other); }
-                T &operator*() { return *iter; }
+                basic_iterator operator++(int) { return basic_iterator(iter++); }
+                basic_iterator operator--(int) { return basic_iterator(iter--); }
+                basic_iterator &operator+=(difference_type n)
+                {
+                    iter += n;
+                    return *this;
+                }
+                basic_iterator &operator-=(difference_type n)
+                {
+                    iter -= n;
+                    return *this;
+                }
+                friend basic_iterator operator+(basic_iterator it, difference_type n) { return it += n; }
+                friend basic_iterator operator+(difference_type n, basic_iterator it) { return it += n; }
+                friend basic_iterator operator-(basic_iterator it, difference_type n) { return it -= n; }
+
+                template <bool C>
+                difference_type operator-(basic_iterator<C> other) const { return iter - other.iter; }
+                template <bool C>
+                bool operator==(basic_iterator<C> other) const { return iter == other.iter; }
+                template <bool C>
+                bool operator!=(basic_iterator<C> other) const { return iter != other.iter; }
+                template <bool C>
+                bool operator<(basic_iterator<C> other) const { return iter < other.iter; }
+                template <bool C>
+                bool operator>(basic_iterator<C> other) const { return iter > other.iter; }
+                template <bool C>
+                bool operator<=(basic_iterator<C> other) const { return iter <= other.iter; }
+                template <bool C>
+                bool operator>=(basic_iterator<C> other) const { return iter >= other.iter; }
             };
 
+            using iterator = basic_iterator<false>;
+            using const_iterator = basic_iterator<true>;
+            using reverse_iterator = std::reverse_iterator<iterator>;
+            using const_reverse_iterator = std::reverse_iterator<const_iterator>;
+
         private:
             void adjust_capacity(const size_t new_reserve)
             {
@@ -100,47 +358,287 @@ namespace slvr
                     return;
                 if (new_reserve < static_cast<size_t>(finish - start))
                     throw std::length_error("too low capacity for data");
-#ifdef DEBUG
-                std::cerr << "allocate from massive::adjust_capacity()" << '\n';
-#endif
-                pointer new_start = m_alloc.allocate(new_reserve);
+                trace::emit<T>(trace::kind::adjust_capacity, new_reserve, start,
+                               static_cast<size_t>(end_of_storage - start));
+                if constexpr (N > 0)
+                {
+                    if (new_reserve <= N)
+                    {
+                        if (!is_inline())
+                            relocate(this->inline_data(), N);
+                        return;
+                    }
+                }
+                if (expand_in_place(new_reserve))
+                    return;
+                relocate(allocate_storage(new_reserve), new_reserve);
+            }
+            bool expand_in_place(const size_t new_reserve)
+            {
+                if constexpr (has_try_expand<A>::value)
+                {
+                    if (start && !is_inline() && m_alloc.try_expand(start, static_cast<size_t>(end_of_storage - start), new_reserve))
+                    {
+                        end_of_storage = start + new_reserve;
+                        return true;
+                    }
+                }
+                return false;
+            }
+            /// Разрушение элементов и возврат памяти аллокатору (встроенный буфер не возвращается)
+            void release_storage() noexcept
+            {
+                destroy_range(start, finish);
+                if (start && !is_inline())
+                    alloc_traits::deallocate(m_alloc, start, static_cast<size_t>(end_of_storage - start));
+                start = finish = end_of_storage = nullptr;
+            }
+            /// Перенос содержимого other в пустой *this; other остается пустым и рабочим
+            void steal(massive &other) noexcept(nothrow_steal)
+            {
+                if (other.is_inline())
+                {
+                    start = finish = this->inline_data();
+                    end_of_storage = start + N;
+                    if constexpr (is_trivially_relocatable<T>::value)
+                    {
+                        size_t n = static_cast<size_t>(other.finish - other.start);
+                        if (n > 0)
+                            std::memcpy(static_cast<void *>(start), static_cast<const void *>(other.start), n * sizeof(T));
+                        finish += n;
+                        other.finish = other.start;
+                    }
+                    else
+                        for (pointer it = other.start; it != other.finish; ++it, ++finish)
+                            alloc_traits::construct(m_alloc, finish, std::move(*it));
+                    other.release_storage();
+                }
+                else
+                {
+                    start = other.start;
+                    finish = other.finish;
+                    end_of_storage = other.end_of_storage;
+                }
+                other.start = other.finish = other.end_of_storage = nullptr;
+                if constexpr (N > 0)
+                {
+                    other.start = other.finish = other.inline_data();
+                    other.end_of_storage = other.start + N;
+                }
+            }
+            pointer allocate_storage(const size_t new_reserve)
+            {
+                pointer new_start = alloc_traits::allocate(m_alloc, new_reserve);
                 if (!new_start)
                     throw std::bad_alloc();
-                pointer new_finish = new_start;
-                if ((finish - start) > 0)
-                    new_finish = std::uninitialized_copy_n(start, static_cast<size_t>(finish - start), new_start);
+                return new_start;
+            }
+            /// Разрушение [first, last); для тривиального деструктора - ничего
+            void destroy_range(pointer first, pointer last) noexcept
+            {
+                if constexpr (!std::is_trivially_destructible<T>::value)
+                    for (; last != first; --last)
+                        alloc_traits::destroy(m_alloc, last - 1);
+                else
+                {
+                    (void)first;
+                    (void)last;
+                }
+            }
+            /// Возврат буфера, выделенного под перенос (встроенный не возвращается)
+            void discard_storage(pointer p, const size_t n) noexcept
+            {
+                if (p != this->inline_data())
+                    alloc_traits::deallocate(m_alloc, p, n);
+            }
+            /**
+            Перенос элементов в новый буфер new_start и освобождение старого.
+            extra - уже построенные в new_start за старыми элементами. Если 
+            копирование бросило исключение, контейнер не меняется, а новый
+            буфер вместе с extra элементами освобождается.
+            */
+            void relocate(pointer new_start, const size_t new_reserve, const size_t extra = 0)
+            {
+                size_t n = static_cast<size_t>(finish - start);
+                if constexpr (is_trivially_relocatable<T>::value)
+                {
+                    if (n > 0)
+                        std::memcpy(static_cast<void *>(new_start), static_cast<const void *>(start), n * sizeof(T));
+                    finish = start; // элементы перенесены, разрушать нечего
+                }
+                else
+                {
+                    size_t i = 0;
+                    try
+                    {
+                        for (; i < n; ++i)
+                            alloc_traits::construct(m_alloc, new_start + i, std::move_if_noexcept(start[i]));
+                    }
+                    catch (...)
+                    {
+                        destroy_range(new_start + n, new_start + n + extra);
+                        destroy_range(new_start, new_start + i);
+                        discard_storage(new_start, new_reserve);
+                        throw;
+                    }
+                }
 
-                for (pointer it = finish; it != start; --it)
-                    m_alloc.destroy(it - 1);
-                m_alloc.deallocate(start, static_cast<size_t>(end_of_storage - start));
+                release_storage();
                 start = new_start;
-                finish = new_finish;
+                finish = new_start + n;
                 end_of_storage = start + new_reserve;
                 return;
             }
             void add_memory()
             {
-                size_t reserve_max = m_alloc.max_size();
+                adjust_capacity(grown_capacity(1));
+            }
+            /// Емкость для еще n элементов за одно наращивание по политике Policy
+            size_t grown_capacity(const size_t n) const
+            {
+                size_t reserve_max = alloc_traits::max_size(m_alloc);
+                size_t old_size = static_cast<size_t>(finish - start);
+                if (n > reserve_max - old_size)
+                    throw std::domain_error("out of allocator memory limit");
+                return Policy::grow(static_cast<size_t>(end_of_storage - start), old_size + n, reserve_max);
+            }
+            template <typename It>
+            static constexpr bool is_contiguous_source =
+                std::is_same<It, pointer>::value || std::is_same<It, const_pointer>::value ||
+                std::is_same<It, iterator>::value || std::is_same<It, const_iterator>::value;
+
+            static const_pointer raw(const_pointer p) { return p; }
+            static const_pointer raw(const_iterator it) { return it.iter; }
 
-                size_t new_reserve = static_cast<size_t>(end_of_storage - start);
-                if (reserve_max / step_koef > new_reserve)
-                    new_reserve = new_reserve * step_koef;
+            template <typename ForwardIt>
+            void construct_range(pointer dest, ForwardIt first, const size_t n)
+            {
+                if constexpr (is_contiguous_source<ForwardIt> && std::is_trivially_copyable<T>::value)
+                {
+                    if (n > 0) // источник пустого диапазона может быть nullptr
+                        std::memcpy(static_cast<void *>(dest), static_cast<const void *>(raw(first)), n * sizeof(T));
+                }
                 else
-                    new_reserve = reserve_max;
-                if (new_reserve <= static_cast<size_t>(end_of_storage - start) )
-                    throw std::domain_error("out of allocator memory limit");
-                adjust_capacity(new_reserve);
+                {
+                    size_t i = 0;
+                    try
+                    {
+                        for (; i < n; ++i, ++first)
+                            alloc_traits::construct(m_alloc, dest + i, *first);
+                    }
+                    catch (...)
+                    {
+                        destroy_range(dest, dest + i);
+                        throw;
+                    }
+                }
+            }
+            /**
+            Добавление n элементов из first. При нехватке места новые элементы
+            строятся в новом буфере до переноса старых, поэтому источник 
+            может лежать в самом контейнере.
+            */
+            template <typename ForwardIt>
+            void append_range(ForwardIt first, const size_t n)
+            {
+                if (static_cast<size_t>(end_of_storage - finish) < n)
+                {
+                    size_t new_reserve = grown_capacity(n);
+                    trace::emit<T>(trace::kind::adjust_capacity, new_reserve, start,
+                                   static_cast<size_t>(end_of_storage - start));
+                    if (!expand_in_place(new_reserve))
+                    {
+                        size_t old_size = static_cast<size_t>(finish - start);
+                        pointer new_start = allocate_storage(new_reserve);
+                        try
+                        {
+                            construct_range(new_start + old_size, first, n);
+                        }
+                        catch (...)
+                        {
+                            discard_storage(new_start, new_reserve);
+                            throw;
+                        }
+                        relocate(new_start, new_reserve, n);
+                        finish += n;
+                        return;
+                    }
+                }
+                construct_range(finish, first, n);
+                finish += n;
             }
 
         public:
             void push_back(const value_type &x)
             {
                 if (static_cast<size_t>(end_of_storage - finish) < 1)
+                {
+                    value_type copy(x); // x может лежать в самом контейнере
                     add_memory();
-                m_alloc.construct(finish, x);
+                    alloc_traits::construct(m_alloc, finish, std::move(copy));
+                }
+                else
+                    alloc_traits::construct(m_alloc, finish, x);
                 ++finish;
                 return;
             }
+            void push_back(value_type &&x)
+            {
+                emplace_back(std::move(x));
+            }
+            template <typename... Args>
+            reference emplace_back(Args &&... args)
+            {
+                if (static_cast<size_t>(end_of_storage - finish) < 1)
+                {
+                    value_type value(std::forward<Args>(args)...);
+                    add_memory();
+                    alloc_traits::construct(m_alloc, finish, std::move(value));
+                }
+                else
+                    alloc_traits::construct(m_alloc, finish, std::forward<Args>(args)...);
+                return *finish++;
+            }
+            /**
+            Добавление диапазона [first, last) в конец. Для однонаправленных 
+            итераторов память резервируется один раз, а непрерывный источник
+            (указатель или итератор massive) копируется одним memcpy.
+            Диапазон может принадлежать самому контейнеру.
+            */
+            template <typename InputIt,
+                      typename = std::enable_if_t<std::is_convertible<
+                          typename std::iterator_traits<InputIt>::iterator_category, std::input_iterator_tag>::value>>
+            void append(InputIt first, InputIt last)
+            {
+                using category = typename std::iterator_traits<InputIt>::iterator_category;
+                if constexpr (std::is_convertible<category, std::forward_iterator_tag>::value)
+                    append_range(first, static_cast<size_t>(std::distance(first, last)));
+                else
+                    for (; first != last; ++first)
+                        emplace_back(*first);
+            }
+            /// Добавление n копий value в конец (для тривиально копируемых - одним memset/fill)
+            void append_n(const value_type &value, size_t n)
+            {
+                if (n == 0)
+                    return;
+                value_type copy(value);
+                if (static_cast<size_t>(end_of_storage - finish) < n)
+                    adjust_capacity(grown_capacity(n));
+                if constexpr (std::is_trivially_copyable<T>::value)
+                {
+                    if constexpr (std::is_integral<T>::value && sizeof(T) == 1)
+                        std::memset(static_cast<void *>(finish), static_cast<unsigned char>(copy), n);
+                    else
+                        std::uninitialized_fill_n(finish, n, copy);
+                    finish += n;
+                }
+                else
+                {
+                    for (; n > 0; --n, ++finish)
+                        alloc_traits::construct(m_alloc, finish, copy);
+                }
+            }
             inline T &operator[](size_t i)
             {
                 if (start == finish)
@@ -150,14 +648,28 @@ namespace slvr
                 throw std::range_error("element number out of range");
                 return *start;
             }
-            iterator begin() const
-            {
-                return iterator(start);
-            }
-            iterator end() const
+            inline const T &operator[](size_t i) const
             {
-                return iterator(finish);
+                if (start == finish)
+                    throw std::range_error("no elements in container");
+                if (i < static_cast<size_t>(finish - start))
+                    return *(start + i);
+                throw std::range_error("element number out of range");
             }
+            T *data() noexcept { return start; }
+            const T *data() const noexcept { return start; }
+            iterator begin() noexcept { return iterator(start); }
+            iterator end() noexcept { return iterator(finish); }
+            const_iterator begin() const noexcept { return const_iterator(start); }
+            const_iterator end() const noexcept { return const_iterator(finish); }
+            const_iterator cbegin() const noexcept { return begin(); }
+            const_iterator cend() const noexcept { return end(); }
+            reverse_iterator rbegin() noexcept { return reverse_iterator(end()); }
+            reverse_iterator rend() noexcept { return reverse_iterator(begin()); }
+            const_reverse_iterator rbegin() const noexcept { return const_reverse_iterator(end()); }
+            const_reverse_iterator rend() const noexcept { return const_reverse_iterator(begin()); }
+            const_reverse_iterator crbegin() const noexcept { return rbegin(); }
+            const_reverse_iterator crend() const noexcept { return rend(); }
             size_t size() const { return finish - start; }
             size_t capacity() const { return end_of_storage - start; }
             void resize(const size_t n)
@@ -165,26 +677,9 @@ namespace slvr
                 if (n >= static_cast<size_t>(finish - start))
                     return;
 
-                for (pointer it = finish; it != start + n; --it)
-                    m_alloc.destroy(it - 1);
+                destroy_range(start + n, finish);
                 finish = start + n;
-                if (n == 0)
-                {
-                    adjust_capacity(min_reserve);
-                    return;
-                }
-                long k_capacity = (end_of_storage - start) / n;
-                if (k_capacity <= step_koef)
-                    return;
-                if (n < min_reserve)
-                {
-                    adjust_capacity(min_reserve);
-                    return;
-                }
-                long k_newcap = ((k_capacity - 1) / step_koef);
-                k_newcap *= step_koef;
-                size_t new_capacity = (end_of_storage - start) / k_newcap + step_koef;
-                adjust_capacity(new_capacity);
+                adjust_capacity(Policy::shrink(static_cast<size_t>(end_of_storage - start), n));
                 return;
             }
             void reserve(const size_t n)
@@ -194,6 +689,116 @@ namespace slvr
                 adjust_capacity(n);
                 return;
             }
+
+            /// Сумма элементов (64 бита, по модулю 2^64), см. simd::sum
+            simd::sum_type<T> sum() const
+            {
+                static_assert(std::is_integral<T>::value, "sum() requires integral elements");
+                return simd::sum(start, size());
+            }
+            T min() const
+            {
+                static_assert(std::is_integral<T>::value, "min() requires integral elements");
+                if (start == finish)
+                    throw std::range_error("no elements in container");
+                return simd::min(start, size());
+            }
+            T max() const
+            {
+                static_assert(std::is_integral<T>::value, "max() requires integral elements");
+                if (start == finish)
+                    throw std::range_error("no elements in container");
+                return simd::max(start, size());
+            }
+            size_t count(const T &value) const
+            {
+                static_assert(std::is_integral<T>::value, "count() requires integral elements");
+                return simd::count(start, size(), value);
+            }
+            iterator find(const T &value)
+            {
+                static_assert(std::is_integral<T>::value, "find() requires integral elements");
+                return iterator(start + simd::find(start, size(), value));
+            }
+            const_iterator find(const T &value) const
+            {
+                static_assert(std::is_integral<T>::value, "find() requires integral elements");
+                return const_iterator(start + simd::find(start, size(), value));
+            }
+            bool contains(const T &value) const
+            {
+                return find(value) != end();
+            }
+            /// Число элементов из [lo, hi] в каждой из bins равных корзин
+            std::vector<size_t> histogram(const T &lo, const T &hi, size_t bins) const
+            {
+                static_assert(std::is_integral<T>::value, "histogram() requires integral elements");
+                return simd::histogram(start, size(), lo, hi, bins);
+            }
+
+            /// f(x) для каждого элемента; куски массива обрабатываются параллельно
+            template <typename F>
+            void parallel_for_each(F f, parallel::thread_pool &pool = parallel::thread_pool::shared())
+            {
+                parallel::for_chunks(start, size(), pool, [&f](pointer first, pointer last) {
+                    for (; first != last; ++first)
+                        f(*first);
+                });
+            }
+            /// Замена каждого элемента x на f(x)
+            template <typename F>
+            void parallel_transform(F f, parallel::thread_pool &pool = parallel::thread_pool::shared())
+            {
+                parallel::for_chunks(start, size(), pool, [&f](pointer first, pointer last) {
+                    for (; first != last; ++first)
+                        *first = f(*first);
+                });
+            }
+            /**
+            Свертка init op x0 op x1 ... ; op должна быть ассоциативной:
+            куски сворачиваются параллельно, затем их итоги - по порядку.
+            */
+            template <typename R, typename Op>
+            R parallel_reduce(R init, Op op, parallel::thread_pool &pool = parallel::thread_pool::shared()) const
+            {
+                if (start == finish)
+                    return init;
+                std::vector<size_t> bounds = parallel::chunk_bounds(start, size(), pool);
+                std::vector<R> partial(bounds.size() - 1, init);
+                pool.run(partial.size(), [&](size_t i) {
+                    const_pointer first = start + bounds[i];
+                    const_pointer last = start + bounds[i + 1];
+                    R acc = static_cast<R>(*first);
+                    for (++first; first != last; ++first)
+                        acc = op(std::move(acc), *first);
+                    partial[i] = std::move(acc);
+                });
+                for (auto &p : partial)
+                    init = op(std::move(init), std::move(p));
+                return init;
+            }
+            /// Сортировка: куски сортируются параллельно и сливаются попарно
+            template <typename Compare = std::less<T>>
+            void parallel_sort(Compare comp = Compare(), parallel::thread_pool &pool = parallel::thread_pool::shared())
+            {
+                if (start == finish)
+                    return;
+                std::vector<size_t> bounds = parallel::chunk_bounds(start, size(), pool);
+                pool.run(bounds.size() - 1, [&](size_t i) { std::sort(start + bounds[i], start + bounds[i + 1], comp); });
+                while (bounds.size() > 2)
+                {
+                    size_t pairs = (bounds.size() - 1) / 2;
+                    pool.run(pairs, [&](size_t i) {
+                        std::inplace_merge(start + bounds[2 * i], start + bounds[2 * i + 1], start + bounds[2 * i + 2], comp);
+                    });
+                    std::vector<size_t> merged;
+                    for (size_t i = 0; i < bounds.size(); i += 2)
+                        merged.push_back(bounds[i]);
+                    if (merged.back() != bounds.back())
+                        merged.push_back(bounds.back());
+                    bounds.swap(merged);
+                }
+            }
         };
 
     } // namespace container
@@ -0,0 +1,354 @@
+/**
+\file
+\brief Векторные ядра для целочисленных данных container::massive
+
+Заголовочный файл с функциями container::simd: сумма, минимум и 
+максимум, подсчет и поиск значения, гистограмма по непрерывному 
+массиву целых чисел. Ядра написаны на векторных расширениях GCC и 
+собираются в двух вариантах - для SSE4.2 и для AVX2; подходящий 
+выбирается во время выполнения по возможностям процессора 
+(active_isa()), на других платформах и для bool используется 
+обычный цикл.
+*/
+#ifndef SLVR_CONTAINER_SIMD_H_
+#define SLVR_CONTAINER_SIMD_H_
+
+#include <cstddef>
+#include <cstring>
+#include <limits>
+#include <type_traits>
+#include <vector>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define SLVR_SIMD_X86 1
+#endif
+
+namespace slvr
+{
+    namespace container
+    {
+        namespace simd
+        {
+            enum class isa
+            {
+                scalar,
+                sse42,
+                avx2
+            };
+
+            inline isa detect_isa()
+            {
+#if defined(SLVR_SIMD_X86)
+                __builtin_cpu_init();
+                if (__builtin_cpu_supports("avx2"))
+                    return isa::avx2;
+                if (__builtin_cpu_supports("sse4.2"))
+                    return isa::sse42;
+#endif
+                return isa::scalar;
+            }
+
+            /// Набор инструкций для ядер; можно понизить, например для сравнения
+            inline isa &active_isa()
+            {
+                static isa current = detect_isa();
+                return current;
+            }
+
+            /// Тип суммы: 64 бита со знаком типа T, переполнение - по модулю 2^64
+            template <typename T>
+            using sum_type = std::conditional_t<std::is_signed<T>::value, long long, unsigned long long>;
+
+            namespace detail
+            {
+                template <typename T>
+                constexpr bool vectorizable = std::is_integral<T>::value && !std::is_same<T, bool>::value;
+
+                template <typename T, std::size_t Bytes>
+                struct vec_of
+                {
+                    typedef T type __attribute__((vector_size(Bytes)));
+                };
+
+                // Векторы передаются только по ссылке: 32-байтные значения
+                // в сигнатуре без AVX меняют ABI
+                template <typename V, typename T>
+                inline __attribute__((always_inline)) void load(V &v, const T *p)
+                {
+                    std::memcpy(&v, p, sizeof(V));
+                }
+
+                template <typename M, std::size_t Bytes>
+                inline __attribute__((always_inline)) bool any(const M &mask)
+                {
+                    using Q = typename vec_of<unsigned long long, Bytes>::type;
+                    Q q;
+                    std::memcpy(&q, &mask, sizeof(Q));
+                    unsigned long long bits = 0;
+                    for (std::size_t k = 0; k < Bytes / 8; ++k)
+                        bits |= q[k];
+                    return bits != 0;
+                }
+
+                template <typename T, std::size_t Bytes>
+                inline __attribute__((always_inline)) sum_type<T> sum_impl(const T *p, std::size_t n)
+                {
+                    constexpr std::size_t lanes = Bytes / 8;
+                    using V = typename vec_of<T, lanes * sizeof(T)>::type;
+                    using W = typename vec_of<unsigned long long, Bytes>::type;
+                    W acc0 = {}, acc1 = {};
+                    std::size_t i = 0;
+                    for (; i + 2 * lanes <= n; i += 2 * lanes)
+                    {
+                        V v0, v1;
+                        load(v0, p + i);
+                        load(v1, p + i + lanes);
+                        acc0 += __builtin_convertvector(v0, W);
+                        acc1 += __builtin_convertvector(v1, W);
+                    }
+                    acc0 += acc1;
+                    unsigned long long s = 0;
+                    for (std::size_t k = 0; k < lanes; ++k)
+                        s += acc0[k];
+                    for (; i < n; ++i)
+                        s += static_cast<unsigned long long>(p[i]);
+                    return static_cast<sum_type<T>>(s);
+                }
+
+                template <typename T, std::size_t Bytes, bool Max>
+                inline __attribute__((always_inline)) T extreme_impl(const T *p, std::size_t n)
+                {
+                    constexpr std::size_t lanes = Bytes / sizeof(T);
+                    using V = typename vec_of<T, Bytes>::type;
+                    T r = p[0];
+                    std::size_t i = 0;
+                    if (n >= lanes)
+                    {
+                        V m, v;
+                        load(m, p);
+                        for (i = lanes; i + lanes <= n; i += lanes)
+                        {
+                            load(v, p + i);
+                            m = Max ? (v > m ? v : m) : (v < m ? v : m);
+                        }
+                        r = m[0];
+                        for (std::size_t k = 1; k < lanes; ++k)
+                            r = Max ? (m[k] > r ? m[k] : r) : (m[k] < r ? m[k] : r);
+                    }
+                    for (; i < n; ++i)
+                        r = Max ? (p[i] > r ? p[i] : r) : (p[i] < r ? p[i] : r);
+                    return r;
+                }
+
+                template <typename T, std::size_t Bytes>
+                inline __attribute__((always_inline)) std::size_t count_impl(const T *p, std::size_t n, T value)
+                {
+                    constexpr std::size_t lanes = Bytes / sizeof(T);
+                    // Счетчики в полосах ширины T сбрасываются раньше, чем переполнятся
+                    constexpr std::size_t block = 127;
+                    using V = typename vec_of<T, Bytes>::type;
+                    V x = value - V{}, v = {};
+                    std::size_t total = 0;
+                    std::size_t i = 0;
+                    while (i + lanes <= n)
+                    {
+                        auto hits = (v != v);
+                        for (std::size_t b = 0; b < block && i + lanes <= n; ++b, i += lanes)
+                        {
+                            load(v, p + i);
+                            hits -= (v == x);
+                        }
+                        for (std::size_t k = 0; k < lanes; ++k)
+                            total += static_cast<std::size_t>(hits[k]);
+                    }
+                    for (; i < n; ++i)
+                        total += (p[i] == value);
+                    return total;
+                }
+
+                template <typename T, std::size_t Bytes>
+                inline __attribute__((always_inline)) std::size_t find_impl(const T *p, std::size_t n, T value)
+                {
+                    constexpr std::size_t lanes = Bytes / sizeof(T);
+                    using V = typename vec_of<T, Bytes>::type;
+                    V x = value - V{}, v;
+                    std::size_t i = 0;
+                    for (; i + lanes <= n; i += lanes)
+                    {
+                        load(v, p + i);
+                        if (any<decltype(v == x), Bytes>(v == x))
+                            break;
+                    }
+                    for (; i < n; ++i)
+                        if (p[i] == value)
+                            return i;
+                    return n;
+                }
+
+                template <typename T>
+                sum_type<T> sum_scalar(const T *p, std::size_t n)
+                {
+                    unsigned long long s = 0;
+                    for (std::size_t i = 0; i < n; ++i)
+                        s += static_cast<unsigned long long>(p[i]);
+                    return static_cast<sum_type<T>>(s);
+                }
+
+                template <typename T, bool Max>
+                T extreme_scalar(const T *p, std::size_t n)
+                {
+                    T r = p[0];
+                    for (std::size_t i = 1; i < n; ++i)
+                        r = Max ? (p[i] > r ? p[i] : r) : (p[i] < r ? p[i] : r);
+                    return r;
+                }
+
+                template <typename T>
+                std::size_t count_scalar(const T *p, std::size_t n, T value)
+                {
+                    std::size_t total = 0;
+                    for (std::size_t i = 0; i < n; ++i)
+                        total += (p[i] == value);
+                    return total;
+                }
+
+                template <typename T>
+                std::size_t find_scalar(const T *p, std::size_t n, T value)
+                {
+                    for (std::size_t i = 0; i < n; ++i)
+                        if (p[i] == value)
+                            return i;
+                    return n;
+                }
+
+#if defined(SLVR_SIMD_X86)
+#define SLVR_SIMD_VARIANT(suffix, target_name, bytes)                                      \
+    template <typename T>                                                                   \
+    __attribute__((target(target_name))) sum_type<T> sum_##suffix(const T *p, std::size_t n) \
+    {                                                                                       \
+        return sum_impl<T, bytes>(p, n);                                                    \
+    }                                                                                       \
+    template <typename T, bool Max>                                                         \
+    __attribute__((target(target_name))) T extreme_##suffix(const T *p, std::size_t n)      \
+    {                                                                                       \
+        return extreme_impl<T, bytes, Max>(p, n);                                           \
+    }                                                                                       \
+    template <typename T>                                                                   \
+    __attribute__((target(target_name))) std::size_t count_##suffix(const T *p, std::size_t n, T value) \
+    {                                                                                       \
+        return count_impl<T, bytes>(p, n, value);                                           \
+    }                                                                                       \
+    template <typename T>                                                                   \
+    __attribute__((target(target_name))) std::size_t find_##suffix(const T *p, std::size_t n, T value) \
+    {                                                                                       \
+        return find_impl<T, bytes>(p, n, value);                                            \
+    }
+
+                SLVR_SIMD_VARIANT(sse42, "sse4.2", 16)
+                SLVR_SIMD_VARIANT(avx2, "avx2", 32)
+#undef SLVR_SIMD_VARIANT
+#endif
+
+            } // namespace detail
+
+#if defined(SLVR_SIMD_X86)
+#define SLVR_SIMD_DISPATCH(kernel, args, ...)                  \
+    if constexpr (detail::vectorizable<T>)                     \
+    {                                                          \
+        switch (active_isa())                                  \
+        {                                                      \
+        case isa::avx2:                                        \
+            return detail::kernel##_avx2<__VA_ARGS__> args;    \
+        case isa::sse42:                                       \
+            return detail::kernel##_sse42<__VA_ARGS__> args;   \
+        default:                                               \
+            break;                                             \
+        }                                                      \
+    }
+#else
+#define SLVR_SIMD_DISPATCH(kernel, args, ...)
+#endif
+
+            template <typename T>
+            sum_type<T> sum(const T *p, std::size_t n)
+            {
+                SLVR_SIMD_DISPATCH(sum, (p, n), T)
+                return detail::sum_scalar(p, n);
+            }
+
+            /// Минимум непустого массива
+            template <typename T>
+            T min(const T *p, std::size_t n)
+            {
+                SLVR_SIMD_DISPATCH(extreme, (p, n), T, false)
+                return detail::extreme_scalar<T, false>(p, n);
+            }
+
+            /// Максимум непустого массива
+            template <typename T>
+            T max(const T *p, std::size_t n)
+            {
+                SLVR_SIMD_DISPATCH(extreme, (p, n), T, true)
+                return detail::extreme_scalar<T, true>(p, n);
+            }
+
+            template <typename T>
+            std::size_t count(const T *p, std::size_t n, T value)
+            {
+                SLVR_SIMD_DISPATCH(count, (p, n, value), T)
+                return detail::count_scalar(p, n, value);
+            }
+
+            /// Индекс первого элемента, равного value, или n
+            template <typename T>
+            std::size_t find(const T *p, std::size_t n, T value)
+            {
+                SLVR_SIMD_DISPATCH(find, (p, n, value), T)
+                return detail::find_scalar(p, n, value);
+            }
+
+#undef SLVR_SIMD_DISPATCH
+
+            /**
+            Гистограмма значений из [lo, hi], разбитых на bins равных корзин; 
+            значения вне диапазона не учитываются. Разброс по корзинам 
+            векторизации не поддается, поэтому подсчет идет в четыре 
+            чередующиеся таблицы, чтобы соседние элементы с одной корзиной
+            не ждали друг друга на записи в память.
+            */
+            template <typename T>
+            std::vector<std::size_t> histogram(const T *p, std::size_t n, T lo, T hi, std::size_t bins)
+            {
+                std::vector<std::size_t> result(bins, 0);
+                if (bins == 0 || hi < lo)
+                    return result;
+                using U = std::make_unsigned_t<std::conditional_t<std::is_same<T, bool>::value, unsigned char, T>>;
+                unsigned long long range = static_cast<U>(static_cast<U>(hi) - static_cast<U>(lo));
+                if (bins == 1 && range == ~0ull)
+                {
+                    // Весь 64-битный тип в одной корзине: ширина range + 1 не помещается в 64 бита
+                    result[0] = n;
+                    return result;
+                }
+                unsigned long long width = range / bins + 1;
+                std::vector<std::size_t> tables(4 * bins, 0);
+                std::size_t i = 0;
+                auto bin_of = [&](T v) { return static_cast<std::size_t>(static_cast<U>(static_cast<U>(v) - static_cast<U>(lo)) / width); };
+                for (; i + 4 <= n; i += 4)
+                    for (std::size_t k = 0; k < 4; ++k)
+                        if (!(p[i + k] < lo) && !(hi < p[i + k]))
+                            ++tables[k * bins + bin_of(p[i + k])];
+                for (; i < n; ++i)
+                    if (!(p[i] < lo) && !(hi < p[i]))
+                        ++tables[bin_of(p[i])];
+                for (std::size_t k = 0; k < 4; ++k)
+                    for (std::size_t b = 0; b < bins; ++b)
+                        result[b] += tables[k * bins + b];
+                return result;
+            }
+
+        } // namespace simd
+    } // namespace container
+} // namespace slvr
+
+#endif /* SLVR_CONTAINER_SIMD_H_ */
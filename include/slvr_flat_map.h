@@ -0,0 +1,432 @@
+/**
+\file
+\brief Определение класса container::flat_map
+
+Заголовочный файл с определением класса container::flat_map -
+упорядоченного словаря в двух непрерывных массивах massive: ключи
+отдельно от значений, оба в порядке возрастания ключа. Поиск -
+двоичный по массиву ключей, без переходов по указателям; вставка и
+удаление в середину сдвигают хвост массивов. Память берется двумя
+блоками через аллокатор (например superK), а не узлом на элемент,
+поэтому блоки целиком возвращаются арене при освобождении.
+Интерфейс повторяет std::map; разыменование итератора дает пару
+ссылок std::pair<const Key &, T &>, а не ссылку на std::pair.
+Большой набор лучше загружать сразу (конструктор из диапазона или
+insert(first, last)): пары сортируются один раз.
+*/
+#ifndef SLVR_FLAT_MAP_H_
+#define SLVR_FLAT_MAP_H_
+
+#include <algorithm>
+#include <cstddef>
+#include <functional>
+#include <initializer_list>
+#include <iterator>
+#include <memory>
+#include <numeric>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#include "slvr_container.h"
+
+namespace slvr
+{
+    namespace container
+    {
+        /// Признак диапазона, уже упорядоченного по ключу и без повторов
+        struct sorted_unique_t
+        {
+            explicit sorted_unique_t() = default;
+        };
+        inline constexpr sorted_unique_t sorted_unique{};
+
+        template <typename Key,
+                  typename T,
+                  typename Compare = std::less<Key>,
+                  typename A = std::allocator<std::pair<const Key, T>>>
+        class flat_map
+        {
+            template <typename U>
+            using rebound = typename std::allocator_traits<A>::template rebind_alloc<U>;
+
+        public:
+            using key_type = Key;
+            using mapped_type = T;
+            using value_type = std::pair<Key, T>;
+            using key_compare = Compare;
+            using allocator_type = A;
+            using size_type = std::size_t;
+            using difference_type = std::ptrdiff_t;
+            using key_container = massive<Key, rebound<Key>>;
+            using mapped_container = massive<T, rebound<T>>;
+
+            /// Итератор по парам: позиция в обоих массивах
+            template <bool Const>
+            class basic_iterator
+            {
+                using owner_type = std::conditional_t<Const, const flat_map, flat_map>;
+                using mapped_ref = std::conditional_t<Const, const T &, T &>;
+
+            public:
+                using iterator_category = std::random_access_iterator_tag;
+                using value_type = std::pair<Key, T>;
+                using difference_type = std::ptrdiff_t;
+                using reference = std::pair<const Key &, mapped_ref>;
+
+                /// operator-> возвращает пару ссылок по значению
+                struct pointer
+                {
+                    reference ref;
+                    const reference *operator->() const { return &ref; }
+                };
+
+                basic_iterator() = default;
+                basic_iterator(owner_type *owner, size_t index) : m_owner(owner), m_index(index) {}
+                operator basic_iterator<true>() const { return basic_iterator<true>(m_owner, m_index); }
+
+                reference operator*() const
+                {
+                    return reference(m_owner->m_keys.data()[m_index], m_owner->m_values.data()[m_index]);
+                }
+                pointer operator->() const { return pointer{**this}; }
+                reference operator[](difference_type n) const { return *(*this + n); }
+
+                basic_iterator &operator++()
+                {
+                    ++m_index;
+                    return *this;
+                }
+                basic_iterator &operator--()
+                {
+                    --m_index;
+                    return *this;
+                }
+                basic_iterator operator++(int) { return basic_iterator(m_owner, m_index++); }
+                basic_iterator operator--(int) { return basic_iterator(m_owner, m_index--); }
+                basic_iterator &operator+=(difference_type n)
+                {
+                    m_index = static_cast<size_t>(static_cast<difference_type>(m_index) + n);
+                    return *this;
+                }
+                basic_iterator &operator-=(difference_type n) { return *this += -n; }
+                friend basic_iterator operator+(basic_iterator it, difference_type n) { return it += n; }
+                friend basic_iterator operator+(difference_type n, basic_iterator it) { return it += n; }
+                friend basic_iterator operator-(basic_iterator it, difference_type n) { return it -= n; }
+
+                template <bool C>
+                difference_type operator-(basic_iterator<C> other) const
+                {
+                    return static_cast<difference_type>(m_index) - static_cast<difference_type>(other.index());
+                }
+                template <bool C>
+                bool operator==(basic_iterator<C> other) const { return m_index == other.index(); }
+                template <bool C>
+                bool operator!=(basic_iterator<C> other) const { return m_index != other.index(); }
+                template <bool C>
+                bool operator<(basic_iterator<C> other) const { return m_index < other.index(); }
+                template <bool C>
+                bool operator>(basic_iterator<C> other) const { return m_index > other.index(); }
+                template <bool C>
+                bool operator<=(basic_iterator<C> other) const { return m_index <= other.index(); }
+                template <bool C>
+                bool operator>=(basic_iterator<C> other) const { return m_index >= other.index(); }
+
+                size_t index() const noexcept { return m_index; }
+
+            private:
+                owner_type *m_owner = nullptr;
+                size_t m_index = 0;
+            };
+
+            using iterator = basic_iterator<false>;
+            using const_iterator = basic_iterator<true>;
+            using reverse_iterator = std::reverse_iterator<iterator>;
+            using const_reverse_iterator = std::reverse_iterator<const_iterator>;
+
+            flat_map() : flat_map(Compare(), A()) {}
+
+            explicit flat_map(const Compare &comp, const A &alloc = A())
+                : m_keys(rebound<Key>(alloc)), m_values(rebound<T>(alloc)), m_comp(comp)
+            {
+            }
+
+            explicit flat_map(const A &alloc) : flat_map(Compare(), alloc) {}
+
+            /// Загрузка диапазона пар: одна сортировка, из повторов остается первый
+            template <typename InputIt>
+            flat_map(InputIt first, InputIt last, const Compare &comp = Compare(), const A &alloc = A())
+                : flat_map(comp, alloc)
+            {
+                insert(first, last);
+            }
+
+            /// Загрузка уже упорядоченных пар без повторов: только копирование
+            template <typename InputIt>
+            flat_map(sorted_unique_t, InputIt first, InputIt last, const Compare &comp = Compare(), const A &alloc = A())
+                : flat_map(comp, alloc)
+            {
+                for (; first != last; ++first)
+                {
+                    m_keys.push_back(first->first);
+                    m_values.push_back(first->second);
+                }
+            }
+
+            /// Загрузка готовых массивов ключей и значений, упорядоченных по ключу
+            flat_map(sorted_unique_t, key_container keys, mapped_container values, const Compare &comp = Compare())
+                : m_keys(std::move(keys)), m_values(std::move(values)), m_comp(comp)
+            {
+                if (m_keys.size() != m_values.size())
+                    throw std::length_error("keys and values differ in size");
+            }
+
+            flat_map(std::initializer_list<value_type> init, const Compare &comp = Compare(), const A &alloc = A())
+                : flat_map(init.begin(), init.end(), comp, alloc)
+            {
+            }
+
+            allocator_type get_allocator() const { return allocator_type(m_keys.get_allocator()); }
+            key_compare key_comp() const { return m_comp; }
+            /// Массивы ключей и значений, например для векторных ядер massive
+            const key_container &keys() const noexcept { return m_keys; }
+            const mapped_container &values() const noexcept { return m_values; }
+
+            iterator begin() noexcept { return iterator(this, 0); }
+            iterator end() noexcept { return iterator(this, size()); }
+            const_iterator begin() const noexcept { return const_iterator(this, 0); }
+            const_iterator end() const noexcept { return const_iterator(this, size()); }
+            const_iterator cbegin() const noexcept { return begin(); }
+            const_iterator cend() const noexcept { return end(); }
+            reverse_iterator rbegin() noexcept { return reverse_iterator(end()); }
+            reverse_iterator rend() noexcept { return reverse_iterator(begin()); }
+            const_reverse_iterator rbegin() const noexcept { return const_reverse_iterator(end()); }
+            const_reverse_iterator rend() const noexcept { return const_reverse_iterator(begin()); }
+
+            size_t size() const noexcept { return m_keys.size(); }
+            bool empty() const noexcept { return size() == 0; }
+            size_t max_size() const noexcept
+            {
+                return std::min(std::allocator_traits<rebound<Key>>::max_size(m_keys.get_allocator()),
+                                std::allocator_traits<rebound<T>>::max_size(m_values.get_allocator()));
+            }
+            void reserve(size_t n)
+            {
+                m_keys.reserve(n);
+                m_values.reserve(n);
+            }
+            void clear()
+            {
+                m_keys.resize(0);
+                m_values.resize(0);
+            }
+
+            iterator lower_bound(const Key &key) { return iterator(this, lower_index(key)); }
+            const_iterator lower_bound(const Key &key) const { return const_iterator(this, lower_index(key)); }
+            iterator upper_bound(const Key &key) { return iterator(this, upper_index(key)); }
+            const_iterator upper_bound(const Key &key) const { return const_iterator(this, upper_index(key)); }
+            std::pair<iterator, iterator> equal_range(const Key &key) { return {lower_bound(key), upper_bound(key)}; }
+            std::pair<const_iterator, const_iterator> equal_range(const Key &key) const
+            {
+                return {lower_bound(key), upper_bound(key)};
+            }
+
+            iterator find(const Key &key) { return iterator(this, find_index(key)); }
+            const_iterator find(const Key &key) const { return const_iterator(this, find_index(key)); }
+            size_t count(const Key &key) const { return find_index(key) != size() ? 1 : 0; }
+            bool contains(const Key &key) const { return find_index(key) != size(); }
+
+            T &at(const Key &key)
+            {
+                size_t i = find_index(key);
+                if (i == size())
+                    throw std::out_of_range("flat_map::at: no such key");
+                return m_values.data()[i];
+            }
+            const T &at(const Key &key) const
+            {
+                size_t i = find_index(key);
+                if (i == size())
+                    throw std::out_of_range("flat_map::at: no such key");
+                return m_values.data()[i];
+            }
+            T &operator[](const Key &key)
+            {
+                return try_emplace(key).first->second;
+            }
+
+            template <typename... Args>
+            std::pair<iterator, bool> try_emplace(const Key &key, Args &&... args)
+            {
+                size_t i = lower_index(key);
+                if (i != size() && !m_comp(key, m_keys.data()[i]))
+                    return {iterator(this, i), false};
+                insert_at(i, key, T(std::forward<Args>(args)...));
+                return {iterator(this, i), true};
+            }
+            template <typename... Args>
+            std::pair<iterator, bool> emplace(Args &&... args)
+            {
+                value_type value(std::forward<Args>(args)...);
+                return try_emplace(value.first, std::move(value.second));
+            }
+            std::pair<iterator, bool> insert(const value_type &value)
+            {
+                return try_emplace(value.first, value.second);
+            }
+            template <typename M>
+            std::pair<iterator, bool> insert_or_assign(const Key &key, M &&obj)
+            {
+                auto result = try_emplace(key, std::forward<M>(obj));
+                if (!result.second)
+                    result.first->second = std::forward<M>(obj);
+                return result;
+            }
+
+            /// Вставка диапазона пар: дописываются в конец, затем одна сортировка и слияние
+            template <typename InputIt>
+            void insert(InputIt first, InputIt last)
+            {
+                size_t old_size = size();
+                try
+                {
+                    for (; first != last; ++first)
+                    {
+                        m_keys.push_back(first->first);
+                        m_values.push_back(first->second);
+                    }
+                }
+                catch (...)
+                {
+                    truncate(old_size);
+                    throw;
+                }
+                if (size() != old_size)
+                    normalize(old_size);
+            }
+            void insert(std::initializer_list<value_type> init) { insert(init.begin(), init.end()); }
+
+            iterator erase(const_iterator pos)
+            {
+                erase_range(pos.index(), pos.index() + 1);
+                return iterator(this, pos.index());
+            }
+            iterator erase(const_iterator first, const_iterator last)
+            {
+                erase_range(first.index(), last.index());
+                return iterator(this, first.index());
+            }
+            size_t erase(const Key &key)
+            {
+                size_t i = find_index(key);
+                if (i == size())
+                    return 0;
+                erase_range(i, i + 1);
+                return 1;
+            }
+
+            void swap(flat_map &other)
+            {
+                std::swap(m_keys, other.m_keys);
+                std::swap(m_values, other.m_values);
+                std::swap(m_comp, other.m_comp);
+            }
+
+            bool operator==(const flat_map &other) const
+            {
+                return size() == other.size() && std::equal(m_keys.begin(), m_keys.end(), other.m_keys.begin()) &&
+                       std::equal(m_values.begin(), m_values.end(), other.m_values.begin());
+            }
+            bool operator!=(const flat_map &other) const { return !(*this == other); }
+
+        private:
+            size_t lower_index(const Key &key) const
+            {
+                return static_cast<size_t>(std::lower_bound(m_keys.data(), m_keys.data() + size(), key, m_comp) -
+                                           m_keys.data());
+            }
+            size_t upper_index(const Key &key) const
+            {
+                return static_cast<size_t>(std::upper_bound(m_keys.data(), m_keys.data() + size(), key, m_comp) -
+                                           m_keys.data());
+            }
+            size_t find_index(const Key &key) const
+            {
+                size_t i = lower_index(key);
+                return i != size() && !m_comp(key, m_keys.data()[i]) ? i : size();
+            }
+
+            void insert_at(size_t i, const Key &key, T value)
+            {
+                size_t old_size = size();
+                try
+                {
+                    m_keys.push_back(key);
+                    m_values.push_back(std::move(value));
+                }
+                catch (...)
+                {
+                    truncate(old_size);
+                    throw;
+                }
+                std::rotate(m_keys.data() + i, m_keys.data() + size() - 1, m_keys.data() + size());
+                std::rotate(m_values.data() + i, m_values.data() + size() - 1, m_values.data() + size());
+            }
+
+            /// Возврат обоих массивов к n парам, если дописывание не удалось
+            void truncate(size_t n)
+            {
+                m_keys.resize(n);
+                m_values.resize(n);
+            }
+
+            void erase_range(size_t first, size_t last)
+            {
+                std::move(m_keys.data() + last, m_keys.data() + size(), m_keys.data() + first);
+                std::move(m_values.data() + last, m_values.data() + size(), m_values.data() + first);
+                size_t new_size = size() - (last - first);
+                m_keys.resize(new_size);
+                m_values.resize(new_size);
+            }
+
+            /**
+            Упорядочивание после дописывания пар с позиции appended: новые
+            пары сортируются по ключу (устойчиво), сливаются со старыми, из
+            повторов остается первый - старый или раньше вставленный.
+            */
+            void normalize(size_t appended)
+            {
+                size_t n = size();
+                std::vector<size_t> order(n);
+                std::iota(order.begin(), order.end(), size_t(0));
+                const Key *keys = m_keys.data();
+                auto by_key = [&](size_t a, size_t b) { return m_comp(keys[a], keys[b]); };
+                std::stable_sort(order.begin() + static_cast<std::ptrdiff_t>(appended), order.end(), by_key);
+                std::inplace_merge(order.begin(), order.begin() + static_cast<std::ptrdiff_t>(appended), order.end(),
+                                   by_key);
+                auto last = std::unique(order.begin(), order.end(),
+                                        [&](size_t a, size_t b) { return !m_comp(keys[a], keys[b]) && !m_comp(keys[b], keys[a]); });
+                order.erase(last, order.end());
+
+                key_container new_keys(m_keys.get_allocator());
+                mapped_container new_values(m_values.get_allocator());
+                new_keys.reserve(order.size());
+                new_values.reserve(order.size());
+                for (size_t i : order)
+                {
+                    new_keys.push_back(keys[i]);
+                    new_values.push_back(std::move(m_values.data()[i]));
+                }
+                m_keys = std::move(new_keys);
+                m_values = std::move(new_values);
+            }
+
+            key_container m_keys;
+            mapped_container m_values;
+            Compare m_comp;
+        };
+
+    } // namespace container
+} // namespace slvr
+
+#endif /* SLVR_FLAT_MAP_H_ */
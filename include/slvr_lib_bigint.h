@@ -0,0 +1,382 @@
+/**
+\file
+\brief Точный факториал больших n: класс lib::biguint и big_factorial(n)
+
+Заголовочный файл с беззнаковым длинным целым lib::biguint (32-битные
+разряды, младшие первыми) и функцией big_factorial(n), считающей n!
+точно. Из сомножителей выносятся степени двойки, нечетные части
+перемножаются деревом произведений (binary splitting): сомножители
+на каждом уровне близки по длине, а длинные числа умножаются
+алгоритмом Карацубы. Независимые поддеревья и три умножения верхних
+уровней Карацубы выполняются параллельно на пуле parallel::thread_pool.
+Десятичная запись (to_string()) строится делением и для чисел в
+миллионы знаков медленна; для проверки и сравнения есть операторы
+== и <, bit_length() и доступ к разрядам.
+*/
+#ifndef SLVR_LIB_BIGINT_H_
+#define SLVR_LIB_BIGINT_H_
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "slvr_thread_pool.h"
+
+namespace slvr
+{
+    namespace lib
+    {
+        class biguint
+        {
+        public:
+            using limb = std::uint32_t;
+            using wide = std::uint64_t;
+            /// Порог перехода от умножения столбиком к Карацубе (в разрядах)
+            static constexpr size_t karatsuba_threshold = 48;
+            /// Порог параллельного выполнения трех умножений Карацубы
+            static constexpr size_t parallel_threshold = 4096;
+
+            biguint() = default;
+            biguint(wide value)
+            {
+                while (value)
+                {
+                    digits.push_back(static_cast<limb>(value));
+                    value >>= 32;
+                }
+            }
+
+            bool is_zero() const noexcept { return digits.empty(); }
+            const std::vector<limb> &limbs() const noexcept { return digits; }
+            size_t bit_length() const noexcept
+            {
+                if (digits.empty())
+                    return 0;
+                return (digits.size() - 1) * 32 + (32 - static_cast<size_t>(__builtin_clz(digits.back())));
+            }
+
+            biguint &operator*=(limb m)
+            {
+                if (m == 0)
+                {
+                    digits.clear();
+                    return *this;
+                }
+                wide carry = 0;
+                for (limb &d : digits)
+                {
+                    wide cur = static_cast<wide>(d) * m + carry;
+                    d = static_cast<limb>(cur);
+                    carry = cur >> 32;
+                }
+                if (carry)
+                    digits.push_back(static_cast<limb>(carry));
+                return *this;
+            }
+
+            /// Сдвиг влево на bits двоичных разрядов
+            biguint &operator<<=(size_t bits)
+            {
+                if (digits.empty())
+                    return *this;
+                size_t whole = bits / 32;
+                unsigned part = static_cast<unsigned>(bits % 32);
+                if (part)
+                {
+                    limb carry = 0;
+                    for (limb &d : digits)
+                    {
+                        limb next = d >> (32 - part);
+                        d = (d << part) | carry;
+                        carry = next;
+                    }
+                    if (carry)
+                        digits.push_back(carry);
+                }
+                digits.insert(digits.begin(), whole, 0);
+                return *this;
+            }
+
+            friend biguint operator*(const biguint &a, const biguint &b) { return multiply(a, b, nullptr); }
+
+            /// Произведение; pool != nullptr - большие умножения выполняются параллельно
+            static biguint multiply(const biguint &a, const biguint &b, parallel::thread_pool *pool)
+            {
+                biguint result;
+                if (a.is_zero() || b.is_zero())
+                    return result;
+                result.digits.assign(a.digits.size() + b.digits.size(), 0);
+                mul(a.digits.data(), a.digits.size(), b.digits.data(), b.digits.size(), result.digits.data(), pool);
+                result.trim();
+                return result;
+            }
+
+            bool operator==(const biguint &other) const { return digits == other.digits; }
+            bool operator!=(const biguint &other) const { return digits != other.digits; }
+            bool operator<(const biguint &other) const
+            {
+                if (digits.size() != other.digits.size())
+                    return digits.size() < other.digits.size();
+                return std::lexicographical_compare(digits.rbegin(), digits.rend(), other.digits.rbegin(),
+                                                    other.digits.rend());
+            }
+
+            /// Десятичная запись; время квадратично от длины числа
+            std::string to_string() const
+            {
+                if (digits.empty())
+                    return "0";
+                std::vector<limb> rest = digits;
+                std::vector<limb> chunks; // по 9 десятичных знаков, младшие первыми
+                while (!rest.empty())
+                {
+                    wide rem = 0;
+                    for (size_t i = rest.size(); i-- > 0;)
+                    {
+                        wide cur = (rem << 32) | rest[i];
+                        rest[i] = static_cast<limb>(cur / 1000000000u);
+                        rem = cur % 1000000000u;
+                    }
+                    chunks.push_back(static_cast<limb>(rem));
+                    while (!rest.empty() && rest.back() == 0)
+                        rest.pop_back();
+                }
+                std::string result = std::to_string(chunks.back());
+                for (size_t i = chunks.size() - 1; i-- > 0;)
+                {
+                    std::string part = std::to_string(chunks[i]);
+                    result.append(9 - part.size(), '0');
+                    result += part;
+                }
+                return result;
+            }
+
+        private:
+            void trim()
+            {
+                while (!digits.empty() && digits.back() == 0)
+                    digits.pop_back();
+            }
+
+            /// r[0..na+nb) = a * b; r заранее обнулен
+            static void schoolbook(const limb *a, size_t na, const limb *b, size_t nb, limb *r)
+            {
+                for (size_t i = 0; i < na; ++i)
+                {
+                    wide carry = 0;
+                    wide ai = a[i];
+                    for (size_t j = 0; j < nb; ++j)
+                    {
+                        wide cur = ai * b[j] + r[i + j] + carry;
+                        r[i + j] = static_cast<limb>(cur);
+                        carry = cur >> 32;
+                    }
+                    r[i + nb] = static_cast<limb>(carry);
+                }
+            }
+
+            /// r[0..nr) += a[0..na), na <= nr; перенос уходит в старшие разряды r
+            static void add_to(limb *r, size_t nr, const limb *a, size_t na)
+            {
+                wide carry = 0;
+                size_t i = 0;
+                for (; i < na; ++i)
+                {
+                    wide cur = static_cast<wide>(r[i]) + a[i] + carry;
+                    r[i] = static_cast<limb>(cur);
+                    carry = cur >> 32;
+                }
+                for (; carry && i < nr; ++i)
+                {
+                    wide cur = static_cast<wide>(r[i]) + carry;
+                    r[i] = static_cast<limb>(cur);
+                    carry = cur >> 32;
+                }
+            }
+
+            /// r[0..nr) -= a[0..na); результат неотрицателен
+            static void sub_from(limb *r, size_t nr, const limb *a, size_t na)
+            {
+                std::int64_t borrow = 0;
+                size_t i = 0;
+                for (; i < na; ++i)
+                {
+                    std::int64_t cur = static_cast<std::int64_t>(r[i]) - a[i] - borrow;
+                    borrow = cur < 0;
+                    r[i] = static_cast<limb>(cur + (borrow << 32));
+                }
+                for (; borrow && i < nr; ++i)
+                {
+                    std::int64_t cur = static_cast<std::int64_t>(r[i]) - borrow;
+                    borrow = cur < 0;
+                    r[i] = static_cast<limb>(cur + (borrow << 32));
+                }
+            }
+
+            /// Сумма младшей и старшей половин: a[0..m) + a[m..na)
+            static std::vector<limb> half_sum(const limb *a, size_t na, size_t m)
+            {
+                std::vector<limb> s(a, a + std::min(na, m));
+                s.resize(std::max(m, na - std::min(na, m)) + 1, 0);
+                if (na > m)
+                    add_to(s.data(), s.size(), a + m, na - m);
+                return s;
+            }
+
+            /// r[0..na+nb) = a * b; r заранее обнулен
+            static void mul(const limb *a, size_t na, const limb *b, size_t nb, limb *r, parallel::thread_pool *pool)
+            {
+                if (na < nb)
+                {
+                    std::swap(a, b);
+                    std::swap(na, nb);
+                }
+                if (nb < karatsuba_threshold)
+                {
+                    schoolbook(a, na, b, nb, r);
+                    return;
+                }
+                if (na >= 2 * nb)
+                {
+                    // Сильно неравные длины: длинный сомножитель режется на куски по nb
+                    std::vector<limb> part(2 * nb);
+                    for (size_t off = 0; off < na; off += nb)
+                    {
+                        size_t len = std::min(nb, na - off);
+                        std::fill(part.begin(), part.end(), 0);
+                        mul(a + off, len, b, nb, part.data(), pool);
+                        add_to(r + off, na + nb - off, part.data(), len + nb);
+                    }
+                    return;
+                }
+
+                size_t m = na / 2;
+                size_t b_lo = std::min(nb, m);
+                std::vector<limb> z0(2 * m, 0);
+                std::vector<limb> z2(na - m + nb - b_lo, 0);
+                std::vector<limb> sa = half_sum(a, na, m);
+                std::vector<limb> sb = half_sum(b, nb, m);
+                std::vector<limb> z1(sa.size() + sb.size(), 0);
+
+                auto low = [&] { mul(a, m, b, b_lo, z0.data(), pool); };
+                auto high = [&] {
+                    if (nb > m)
+                        mul(a + m, na - m, b + m, nb - m, z2.data(), pool);
+                };
+                auto mid = [&] { mul(sa.data(), sa.size(), sb.data(), sb.size(), z1.data(), pool); };
+                if (pool && nb >= parallel_threshold)
+                    pool->run(3, [&](size_t i) { i == 0 ? low() : i == 1 ? high() : mid(); });
+                else
+                {
+                    low();
+                    high();
+                    mid();
+                }
+
+                sub_from(z1.data(), z1.size(), z0.data(), z0.size());
+                sub_from(z1.data(), z1.size(), z2.data(), z2.size());
+                size_t nr = na + nb;
+                add_to(r, nr, z0.data(), std::min(z0.size(), nr));
+                size_t z1_len = z1.size();
+                while (z1_len && z1[z1_len - 1] == 0)
+                    --z1_len;
+                add_to(r + m, nr - m, z1.data(), std::min(z1_len, nr - m));
+                size_t z2_len = z2.size();
+                while (z2_len && z2[z2_len - 1] == 0)
+                    --z2_len;
+                add_to(r + 2 * m, nr - 2 * m, z2.data(), std::min(z2_len, nr - 2 * m));
+            }
+
+            std::vector<limb> digits;
+        };
+
+        namespace detail
+        {
+            /// Нечетная часть числа i и показатель вынесенной двойки
+            inline std::uint32_t odd_part(std::uint32_t i, size_t &twos)
+            {
+                unsigned tz = static_cast<unsigned>(__builtin_ctz(i));
+                twos += tz;
+                return i >> tz;
+            }
+
+            /// Произведение нечетных частей чисел [lo, hi) деревом произведений; hi до 2^32
+            inline biguint odd_product(std::uint64_t lo, std::uint64_t hi, size_t &twos, parallel::thread_pool *pool)
+            {
+                if (hi - lo <= 16)
+                {
+                    biguint result(1);
+                    biguint::wide acc = 1;
+                    for (std::uint64_t i = lo; i < hi; ++i)
+                    {
+                        std::uint32_t odd = odd_part(static_cast<std::uint32_t>(i), twos);
+                        if (acc > 0xffffffffu / odd)
+                        {
+                            result *= static_cast<biguint::limb>(acc);
+                            acc = 1;
+                        }
+                        acc *= odd;
+                    }
+                    result *= static_cast<biguint::limb>(acc);
+                    return result;
+                }
+                std::uint64_t mid = lo + (hi - lo) / 2;
+                biguint left = odd_product(lo, mid, twos, nullptr);
+                biguint right = odd_product(mid, hi, twos, nullptr);
+                return biguint::multiply(left, right, pool);
+            }
+        } // namespace detail
+
+        /**
+        Точное значение n!. pool != nullptr - поддеревья произведений
+        и большие умножения выполняются параллельно на пуле.
+        */
+        inline biguint big_factorial(std::uint32_t n, parallel::thread_pool *pool = nullptr)
+        {
+            if (n < 2)
+                return biguint(1);
+            size_t twos = 0;
+            std::uint64_t last = std::uint64_t(n) + 1; // n = 2^32 - 1 не переполняет границу
+            biguint result;
+            size_t segments = pool ? pool->concurrency() * parallel::chunks_per_thread : 1;
+            if (segments <= 1 || n < 1024)
+                result = detail::odd_product(1, last, twos, nullptr);
+            else
+            {
+                // Отрезки равной длины; каждый считается отдельной задачей пула
+                std::vector<std::uint64_t> bounds{1};
+                for (size_t i = 1; i < segments; ++i)
+                    bounds.push_back(std::max(bounds.back(), static_cast<std::uint64_t>(
+                                                                 static_cast<double>(last) * static_cast<double>(i) / static_cast<double>(segments))));
+                bounds.push_back(last);
+                std::vector<biguint> parts(segments);
+                std::vector<size_t> part_twos(segments, 0);
+                pool->run(segments, [&](size_t i) {
+                    parts[i] = detail::odd_product(bounds[i], bounds[i + 1], part_twos[i], nullptr);
+                });
+                for (size_t t : part_twos)
+                    twos += t;
+                // Попарное перемножение соседних частей уровнями дерева
+                while (parts.size() > 1)
+                {
+                    std::vector<biguint> next((parts.size() + 1) / 2);
+                    pool->run(parts.size() / 2, [&](size_t i) {
+                        next[i] = biguint::multiply(parts[2 * i], parts[2 * i + 1], pool);
+                    });
+                    if (parts.size() % 2)
+                        next.back() = std::move(parts.back());
+                    parts.swap(next);
+                }
+                result = std::move(parts.front());
+            }
+            result <<= twos;
+            return result;
+        }
+
+    } // namespace lib
+} // namespace slvr
+
+#endif /* SLVR_LIB_BIGINT_H_ */
@@ -1,39 +1,242 @@
 /**
 \file
-\brief Реализация функции llfactorial(n)
+\brief Реализация функции llfactorial(n) и таблиц факториалов
 
-Функция вычисляет факториал от n. Знак n не учитывается (отбрасывается).  
+Функция вычисляет факториал от n. Знак n не учитывается (отбрасывается).
+Значения берутся из таблиц, построенных при компиляции: факториалы,
+помещающиеся в long long (до 20!), и в unsigned __int128 (до 34!,
+u128factorial()). Переполнение при построении таблиц и в checked_factorial()
+определяется встроенным умножением с проверкой. Биномиальные коэффициенты
+до n = 67 тоже берутся из таблицы (binomial()); mod_factorials хранит
+факториалы и обратные к ним по простому модулю для пакетного вычисления
+factorial_mod() и binomial() по модулю.
 */
 #ifndef SLVR_LIB_FACTORIAL_H_
 #define SLVR_LIB_FACTORIAL_H_
 
-#include <cmath>
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
 #include <stdexcept>
+#include <type_traits>
+#include <vector>
 
 namespace slvr
 {
 
     namespace lib
     {
+        __extension__ typedef unsigned __int128 uint128;
 
-        long long llfactorial(const int n) 
+        /// Наибольшее n, для которого n! помещается в T
+        template <typename T>
+        constexpr unsigned max_factorial()
         {
-            if ( n == 0 ) 
-                return 1;
-            long long res = 1;
-            for (int i = abs(n); i > 0; i--) 
-            { 
-                long long temp = res;
-                res = res * i;  
-                if (temp > res) 
-                    throw std::overflow_error("llfactorial function result is too big");
+            T f = 1;
+            unsigned n = 1;
+            while (!__builtin_mul_overflow(f, static_cast<T>(n + 1), &f))
+                ++n;
+            return n;
+        }
+
+        /// Таблица 0!..max_factorial<T>()!
+        template <typename T>
+        constexpr std::array<T, max_factorial<T>() + 1> make_factorial_table()
+        {
+            std::array<T, max_factorial<T>() + 1> table{};
+            table[0] = 1;
+            for (size_t i = 1; i < table.size(); ++i)
+                table[i] = table[i - 1] * static_cast<T>(i);
+            return table;
+        }
+
+        template <typename T>
+        inline constexpr auto factorial_table = make_factorial_table<T>();
+
+        /// Модуль n без переполнения на INT_MIN
+        constexpr unsigned magnitude(int n)
+        {
+            return n < 0 ? 0u - static_cast<unsigned>(n) : static_cast<unsigned>(n);
+        }
+
+        /// n! в типе T; не помещается - std::overflow_error
+        template <typename T>
+        constexpr T checked_factorial(unsigned n)
+        {
+            if (n >= factorial_table<T>.size())
+                throw std::overflow_error("factorial result is too big");
+            return factorial_table<T>[n];
+        }
+
+        inline long long llfactorial(const int n)
+        {
+            if (magnitude(n) >= factorial_table<long long>.size())
+                throw std::overflow_error("llfactorial function result is too big");
+            return factorial_table<long long>[magnitude(n)];
+        }
+
+        /// |n|! до 34!
+        inline uint128 u128factorial(const int n)
+        {
+            if (magnitude(n) >= factorial_table<uint128>.size())
+                throw std::overflow_error("u128factorial function result is too big");
+            return factorial_table<uint128>[magnitude(n)];
+        }
+
+        namespace detail
+        {
+            /// Наибольшее n, при котором все C(n, k) помещаются в unsigned long long
+            constexpr unsigned binomial_rows = 68;
+
+            /// Треугольник Паскаля, строки подряд: C(n, k) в элементе n * (n + 1) / 2 + k
+            constexpr std::array<unsigned long long, binomial_rows *(binomial_rows + 1) / 2> make_binomial_table()
+            {
+                std::array<unsigned long long, binomial_rows *(binomial_rows + 1) / 2> table{};
+                for (size_t n = 0; n < binomial_rows; ++n)
+                {
+                    size_t row = n * (n + 1) / 2;
+                    table[row] = table[row + n] = 1;
+                    for (size_t k = 1; k < n; ++k)
+                        table[row + k] = table[row - n + k - 1] + table[row - n + k];
+                }
+                return table;
             }
+
+            inline constexpr auto binomial_table = make_binomial_table();
+        } // namespace detail
+
+        /// Точное C(n, k); не помещается в unsigned long long - std::overflow_error
+        inline unsigned long long binomial(unsigned n, unsigned k)
+        {
+            if (k > n)
+                return 0;
+            if (k > n - k)
+                k = n - k;
+            if (n < detail::binomial_rows)
+                return detail::binomial_table[n * (n + 1) / 2 + k];
+            // C(n, i) = C(n, i - 1) * (n - i + 1) / i, деление всегда нацело
+            unsigned long long res = 1;
+            for (unsigned i = 1; i <= k; ++i)
+            {
+                uint128 next = static_cast<uint128>(res) * (n - i + 1) / i;
+                if (next > ~0ull)
+                    throw std::overflow_error("binomial result is too big");
+                res = static_cast<unsigned long long>(next);
+            }
+            return res;
+        }
+
+        /// n! mod p без таблиц, за O(n)
+        inline unsigned long long factorial_mod(unsigned long long n, unsigned long long p)
+        {
+            if (p == 0)
+                throw std::invalid_argument("factorial_mod modulus is zero");
+            if (n >= p)
+                return 0;
+            unsigned long long res = 1 % p;
+            for (unsigned long long i = 2; i <= n; ++i)
+                res = static_cast<unsigned long long>(static_cast<uint128>(res) * i % p);
             return res;
-        }  
+        }
+
+        /**
+        Факториалы и обратные к ним по простому модулю p для n до n_max
+        (и не дальше p - 1): factorial() и binomial() за O(1) после
+        построения за O(n_max). C(n, k) для n >= p считается по теореме
+        Люка. Пакетные варианты заполняют выходной диапазон по входному.
+        */
+        class mod_factorials
+        {
+        public:
+            mod_factorials(unsigned long long n_max, unsigned long long p) : m_p(p)
+            {
+                if (p < 2)
+                    throw std::invalid_argument("mod_factorials modulus must be prime");
+                size_t size = static_cast<size_t>(std::min(n_max, p - 1)) + 1;
+                m_fact.resize(size);
+                m_inv.resize(size);
+                m_fact[0] = 1;
+                for (size_t i = 1; i < size; ++i)
+                    m_fact[i] = mul(m_fact[i - 1], i);
+                m_inv[size - 1] = power(m_fact[size - 1], p - 2);
+                for (size_t i = size - 1; i > 0; --i)
+                    m_inv[i - 1] = mul(m_inv[i], i);
+            }
+
+            unsigned long long modulus() const noexcept { return m_p; }
+            unsigned long long n_max() const noexcept { return m_fact.size() - 1; }
+
+            /// n! mod p
+            unsigned long long factorial(unsigned long long n) const
+            {
+                if (n >= m_p)
+                    return 0;
+                return m_fact.at(static_cast<size_t>(n));
+            }
+
+            /// (n!)^-1 mod p, n < p
+            unsigned long long inverse_factorial(unsigned long long n) const { return m_inv.at(static_cast<size_t>(n)); }
+
+            /// C(n, k) mod p
+            unsigned long long binomial(unsigned long long n, unsigned long long k) const
+            {
+                if (k > n)
+                    return 0;
+                unsigned long long res = 1;
+                while (n || k)
+                {
+                    unsigned long long ni = n % m_p, ki = k % m_p;
+                    if (ki > ni)
+                        return 0;
+                    res = mul(res, mul(m_fact.at(static_cast<size_t>(ni)),
+                                       mul(m_inv.at(static_cast<size_t>(ki)), m_inv.at(static_cast<size_t>(ni - ki)))));
+                    n /= m_p;
+                    k /= m_p;
+                }
+                return res;
+            }
+
+            /// n! mod p для каждого n из [first, last)
+            template <typename InputIt, typename OutputIt>
+            OutputIt factorial(InputIt first, InputIt last, OutputIt out) const
+            {
+                for (; first != last; ++first, ++out)
+                    *out = factorial(*first);
+                return out;
+            }
+
+            /// C(n, k) mod p для каждой пары (n, k) из [first, last)
+            template <typename InputIt, typename OutputIt>
+            OutputIt binomial(InputIt first, InputIt last, OutputIt out) const
+            {
+                for (; first != last; ++first, ++out)
+                    *out = binomial(first->first, first->second);
+                return out;
+            }
+
+        private:
+            unsigned long long mul(unsigned long long a, unsigned long long b) const
+            {
+                return static_cast<unsigned long long>(static_cast<uint128>(a) * b % m_p);
+            }
+
+            unsigned long long power(unsigned long long a, unsigned long long e) const
+            {
+                unsigned long long res = 1 % m_p;
+                for (; e; e >>= 1, a = mul(a, a))
+                    if (e & 1)
+                        res = mul(res, a);
+                return res;
+            }
 
+            unsigned long long m_p;
+            std::vector<unsigned long long> m_fact;
+            std::vector<unsigned long long> m_inv;
+        };
 
     } // namespace lib
 
 } // namespace slvr
 
-#endif /* SLVR_LIB_FACTORIAL_H_ */
\ No newline at end of file
+#endif /* SLVR_LIB_FACTORIAL_H_ */
@@ -0,0 +1,460 @@
+/**
+\file
+\brief Определение класса container::packed_massive
+
+Заголовочный файл с определением класса container::packed_massive -
+сжатого массива целых чисел. Элементы хранятся блоками по 128 значений;
+каждый блок упаковывается по битам до ширины, нужной именно ему:
+смещения от минимума блока (frame of reference) или, если блок
+отсортирован, разности соседних по строке значений (дельта-кодирование),
+когда они уже. Значения блока разложены по четырем 64-битным полосам,
+поэтому распаковка идет векторами по четыре значения с одинаковым
+сдвигом, без выборки по индексам. Сумма (sum()) считается ядрами,
+развернутыми для каждой ширины отдельно. Последние (неполные) 128 значений
+хранятся без сжатия до заполнения блока.
+Поддерживаются push_back(), последовательный обход, доступ к блоку
+целиком (decode_block(), for_each_block()) и к элементу по номеру
+(с распаковкой его блока).
+*/
+#ifndef SLVR_PACKED_H_
+#define SLVR_PACKED_H_
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <iterator>
+#include <memory>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "slvr_container_simd.h"
+
+namespace slvr
+{
+    namespace container
+    {
+        enum class packing
+        {
+            /// Только смещения от минимума блока
+            frame_of_reference,
+            /// Разности для отсортированных блоков, если они уже смещений
+            delta_when_sorted
+        };
+
+        namespace packed_detail
+        {
+            constexpr size_t block_size = 128;
+            constexpr size_t lanes = 4;
+            constexpr size_t rows = block_size / lanes;
+
+            /// Слов одной полосы для значений ширины width
+            constexpr size_t lane_words(unsigned width) { return (rows * width + 63) / 64; }
+
+            inline unsigned bit_width(std::uint64_t x)
+            {
+                return x ? 64u - static_cast<unsigned>(__builtin_clzll(x)) : 0u;
+            }
+
+            /**
+            Распаковка блока: строка j - четыре значения полос с битовым
+            смещением j * width, у всех полос одинаковым.
+            delta - значения накапливаются от base построчно.
+            */
+            template <typename T>
+            inline __attribute__((always_inline)) void unpack_impl(const std::uint64_t *words, unsigned width,
+                                                                   bool delta, std::uint64_t base, T *out)
+            {
+                using V = typename simd::detail::vec_of<std::uint64_t, 32>::type;
+                using VT = typename simd::detail::vec_of<T, lanes * sizeof(T)>::type;
+                const std::uint64_t mask = width == 64 ? ~0ull : (1ull << width) - 1;
+                V acc = base - V{};
+                V lo, hi;
+                for (size_t j = 0; j < rows; ++j)
+                {
+                    size_t bit = j * width;
+                    size_t k = bit >> 6;
+                    unsigned s = static_cast<unsigned>(bit & 63);
+                    simd::detail::load(lo, words + lanes * k);
+                    V v = lo >> s;
+                    if (s + width > 64)
+                    {
+                        simd::detail::load(hi, words + lanes * (k + 1));
+                        v |= hi << (64 - s);
+                    }
+                    v &= mask;
+                    if (delta)
+                        acc += v;
+                    else
+                        acc = v + base;
+                    VT narrow = __builtin_convertvector(acc, VT);
+                    std::memcpy(out + lanes * j, &narrow, sizeof(narrow));
+                }
+            }
+
+            /**
+            Сумма значений блока по модулю 2^64 без записи распакованных значений.
+            Ширина - параметр шаблона: строки развертываются полностью, сдвиги
+            и выбор слов становятся константами, ветвлений в цикле нет.
+            */
+            template <unsigned Width, bool Delta>
+            inline __attribute__((always_inline)) std::uint64_t sum_impl(const std::uint64_t *words, std::uint64_t base)
+            {
+                using V = typename simd::detail::vec_of<std::uint64_t, 32>::type;
+                constexpr std::uint64_t mask = Width == 64 ? ~0ull : (1ull << Width) - 1;
+                V acc = base - V{};
+                V total = {};
+                V lo, hi;
+#pragma GCC unroll 32
+                for (size_t j = 0; j < rows; ++j)
+                {
+                    const size_t bit = j * Width;
+                    const size_t k = bit >> 6;
+                    const unsigned s = static_cast<unsigned>(bit & 63);
+                    simd::detail::load(lo, words + lanes * k);
+                    V v = lo >> s;
+                    if (s + Width > 64)
+                    {
+                        simd::detail::load(hi, words + lanes * (k + 1));
+                        v |= hi << (64 - s);
+                    }
+                    v &= mask;
+                    if (Delta)
+                    {
+                        acc += v;
+                        total += acc;
+                    }
+                    else
+                        total += v;
+                }
+                std::uint64_t result = Delta ? 0 : base * block_size;
+                for (size_t l = 0; l < lanes; ++l)
+                    result += total[l];
+                return result;
+            }
+
+            using sum_kernel = std::uint64_t (*)(const std::uint64_t *, std::uint64_t);
+
+            template <unsigned Width, bool Delta>
+            std::uint64_t sum_generic(const std::uint64_t *words, std::uint64_t base)
+            {
+                return sum_impl<Width, Delta>(words, base);
+            }
+
+            /// Таблица ядер суммы по ширине 0..64
+            template <bool Delta, size_t... Width>
+            constexpr std::array<sum_kernel, 65> generic_sum_kernels(std::index_sequence<Width...>)
+            {
+                return {{&sum_generic<static_cast<unsigned>(Width), Delta>...}};
+            }
+
+            template <typename T>
+            void unpack_generic(const std::uint64_t *words, unsigned width, bool delta, std::uint64_t base, T *out)
+            {
+                unpack_impl(words, width, delta, base, out);
+            }
+
+#if defined(SLVR_SIMD_X86)
+            template <typename T>
+            __attribute__((target("avx2"))) void unpack_avx2(const std::uint64_t *words, unsigned width,
+                                                             bool delta, std::uint64_t base, T *out)
+            {
+                unpack_impl(words, width, delta, base, out);
+            }
+
+            template <unsigned Width, bool Delta>
+            __attribute__((target("avx2"))) std::uint64_t sum_avx2(const std::uint64_t *words, std::uint64_t base)
+            {
+                return sum_impl<Width, Delta>(words, base);
+            }
+
+            template <bool Delta, size_t... Width>
+            constexpr std::array<sum_kernel, 65> avx2_sum_kernels(std::index_sequence<Width...>)
+            {
+                return {{&sum_avx2<static_cast<unsigned>(Width), Delta>...}};
+            }
+#endif
+
+            /// Ядро суммы для блоков ширины width (1..64)
+            inline sum_kernel sum_kernel_for(unsigned width, bool delta)
+            {
+                using widths = std::make_index_sequence<65>;
+#if defined(SLVR_SIMD_X86)
+                static constexpr std::array<sum_kernel, 65> avx2[2] = {avx2_sum_kernels<false>(widths{}),
+                                                                      avx2_sum_kernels<true>(widths{})};
+                if (simd::active_isa() == simd::isa::avx2)
+                    return avx2[delta][width];
+#endif
+                static constexpr std::array<sum_kernel, 65> generic[2] = {generic_sum_kernels<false>(widths{}),
+                                                                         generic_sum_kernels<true>(widths{})};
+                return generic[delta][width];
+            }
+
+            inline std::uint64_t sum(const std::uint64_t *words, unsigned width, bool delta, std::uint64_t base)
+            {
+                if (width == 0)
+                    return base * block_size;
+                return sum_kernel_for(width, delta)(words, base);
+            }
+
+            template <typename T>
+            void unpack(const std::uint64_t *words, unsigned width, bool delta, std::uint64_t base, T *out)
+            {
+                if (width == 0)
+                {
+                    std::fill_n(out, block_size, static_cast<T>(base));
+                    return;
+                }
+#if defined(SLVR_SIMD_X86)
+                if (simd::active_isa() == simd::isa::avx2)
+                    return unpack_avx2(words, width, delta, base, out);
+#endif
+                unpack_generic(words, width, delta, base, out);
+            }
+        } // namespace packed_detail
+
+        template <typename T, typename A = std::allocator<T>>
+        class packed_massive
+        {
+            static_assert(std::is_integral<T>::value && !std::is_same<T, bool>::value,
+                          "packed_massive stores integral values");
+
+        public:
+            using value_type = T;
+            using size_type = std::size_t;
+            using difference_type = std::ptrdiff_t;
+            using allocator_type = A;
+            static constexpr size_t block_size = packed_detail::block_size;
+
+        private:
+            struct block_info
+            {
+                std::uint64_t base;
+                size_t offset;
+                unsigned char width;
+                bool delta;
+            };
+            template <typename U>
+            using rebound = typename std::allocator_traits<A>::template rebind_alloc<U>;
+
+            std::vector<block_info, rebound<block_info>> blocks;
+            std::vector<std::uint64_t, rebound<std::uint64_t>> words;
+            T tail[block_size];
+            size_t tail_size;
+            packing mode;
+
+        public:
+            explicit packed_massive(packing m = packing::delta_when_sorted, const allocator_type &alloc = allocator_type())
+                : blocks(rebound<block_info>(alloc)), words(rebound<std::uint64_t>(alloc)), tail(), tail_size(0), mode(m)
+            {
+            }
+
+            void push_back(const T &x)
+            {
+                tail[tail_size++] = x;
+                if (tail_size == block_size)
+                {
+                    seal(tail);
+                    tail_size = 0;
+                }
+            }
+
+            template <typename InputIt>
+            void append(InputIt first, InputIt last)
+            {
+                for (; first != last; ++first)
+                    push_back(*first);
+            }
+
+            size_t size() const noexcept { return blocks.size() * block_size + tail_size; }
+            bool empty() const noexcept { return size() == 0; }
+            /// Число блоков, включая неполный последний
+            size_t block_count() const noexcept { return blocks.size() + (tail_size ? 1 : 0); }
+            /// Ширина упаковки блока b в битах (для неполного блока - sizeof(T) * 8)
+            unsigned block_width(size_t b) const
+            {
+                check_block(b);
+                return b < blocks.size() ? blocks[b].width : static_cast<unsigned>(sizeof(T) * 8);
+            }
+            bool block_is_delta(size_t b) const
+            {
+                check_block(b);
+                return b < blocks.size() && blocks[b].delta;
+            }
+
+            /// Распаковка блока b в out (до block_size значений); возвращает их число
+            size_t decode_block(size_t b, T *out) const
+            {
+                check_block(b);
+                if (b == blocks.size())
+                {
+                    std::copy_n(tail, tail_size, out);
+                    return tail_size;
+                }
+                const block_info &info = blocks[b];
+                packed_detail::unpack(words.data() + info.offset, info.width, info.delta, info.base, out);
+                return block_size;
+            }
+
+            /// f(values, n) для каждого блока по порядку
+            template <typename F>
+            void for_each_block(F f) const
+            {
+                T buffer[block_size];
+                for (size_t b = 0; b < blocks.size(); ++b)
+                {
+                    decode_block(b, buffer);
+                    f(static_cast<const T *>(buffer), block_size);
+                }
+                if (tail_size)
+                    f(static_cast<const T *>(tail), tail_size);
+            }
+
+            /// Элемент по номеру: распаковывает его блок, для обхода лучше итераторы
+            T operator[](size_t i) const
+            {
+                if (i >= size())
+                    throw std::range_error("element number out of range");
+                T buffer[block_size];
+                decode_block(i / block_size, buffer);
+                return buffer[i % block_size];
+            }
+
+            simd::sum_type<T> sum() const
+            {
+                std::uint64_t s = 0;
+                for (const block_info &info : blocks)
+                    s += packed_detail::sum(words.data() + info.offset, info.width, info.delta, info.base);
+                s += static_cast<std::uint64_t>(simd::sum(tail, tail_size));
+                return static_cast<simd::sum_type<T>>(s);
+            }
+
+            /// Байт, занятых данными: упакованные слова, описания блоков, хвост
+            size_t memory_bytes() const noexcept
+            {
+                return words.capacity() * sizeof(std::uint64_t) + blocks.capacity() * sizeof(block_info) + sizeof(tail);
+            }
+
+            /**
+            Последовательный обход. Распакованный блок лежит в курсоре, общем
+            для копий итератора, поэтому копирование итератора дешево; копия,
+            стоящая в другом блоке, распакует свой блок заново при разыменовании.
+            Ссылка на элемент действительна до распаковки другого блока.
+            */
+            class const_iterator
+            {
+                struct cursor
+                {
+                    size_t block = ~size_t(0);
+                    T values[block_size];
+                };
+
+            public:
+                using iterator_category = std::input_iterator_tag;
+                using value_type = T;
+                using difference_type = std::ptrdiff_t;
+                using pointer = const T *;
+                using reference = const T &;
+
+                const_iterator() = default;
+                const_iterator(const packed_massive *owner, size_t index)
+                    : m_owner(owner), m_index(index), m_cursor(owner ? std::make_shared<cursor>() : nullptr)
+                {
+                }
+
+                reference operator*() const
+                {
+                    size_t b = m_index / block_size;
+                    if (m_cursor->block != b)
+                    {
+                        m_owner->decode_block(b, m_cursor->values);
+                        m_cursor->block = b;
+                    }
+                    return m_cursor->values[m_index % block_size];
+                }
+                pointer operator->() const { return &**this; }
+                const_iterator &operator++()
+                {
+                    ++m_index;
+                    return *this;
+                }
+                const_iterator operator++(int)
+                {
+                    const_iterator old = *this;
+                    ++*this;
+                    return old;
+                }
+                bool operator==(const const_iterator &other) const { return m_index == other.m_index; }
+                bool operator!=(const const_iterator &other) const { return m_index != other.m_index; }
+
+            private:
+                const packed_massive *m_owner = nullptr;
+                size_t m_index = 0;
+                std::shared_ptr<cursor> m_cursor;
+            };
+
+            const_iterator begin() const { return const_iterator(this, 0); }
+            const_iterator end() const { return const_iterator(nullptr, size()); }
+
+        private:
+            void check_block(size_t b) const
+            {
+                if (b >= block_count())
+                    throw std::range_error("block number out of range");
+            }
+
+            static std::uint64_t wide(T x) { return static_cast<std::uint64_t>(x); }
+
+            /// Упаковка полного блока values
+            void seal(const T *values)
+            {
+                using namespace packed_detail;
+                T lo = *std::min_element(values, values + block_size);
+                T hi = *std::max_element(values, values + block_size);
+                std::uint64_t deltas[block_size];
+                for (size_t i = 0; i < block_size; ++i)
+                    deltas[i] = wide(values[i]) - wide(lo);
+
+                block_info info{wide(lo), words.size(), static_cast<unsigned char>(bit_width(wide(hi) - wide(lo))), false};
+                if (mode == packing::delta_when_sorted && std::is_sorted(values, values + block_size))
+                {
+                    // Разности по полосам: со строкой выше, первая строка - от values[0]
+                    std::uint64_t stride[block_size];
+                    std::uint64_t widest = 0;
+                    for (size_t i = 0; i < block_size; ++i)
+                    {
+                        stride[i] = wide(values[i]) - wide(i < lanes ? values[0] : values[i - lanes]);
+                        widest |= stride[i];
+                    }
+                    unsigned delta_width = bit_width(widest);
+                    if (delta_width < info.width)
+                    {
+                        info = block_info{wide(values[0]), words.size(), static_cast<unsigned char>(delta_width), true};
+                        std::copy_n(stride, block_size, deltas);
+                    }
+                }
+
+                size_t per_lane = lane_words(info.width);
+                words.resize(words.size() + lanes * per_lane, 0);
+                std::uint64_t *out = words.data() + info.offset;
+                for (size_t i = 0; info.width != 0 && i < block_size; ++i) // ширина 0 - слов нет
+                {
+                    size_t bit = (i / lanes) * info.width;
+                    size_t k = bit >> 6;
+                    unsigned s = static_cast<unsigned>(bit & 63);
+                    size_t lane = i % lanes;
+                    out[lanes * k + lane] |= deltas[i] << s;
+                    if (s + info.width > 64)
+                        out[lanes * (k + 1) + lane] |= deltas[i] >> (64 - s);
+                }
+                blocks.push_back(info);
+            }
+        };
+
+    } // namespace container
+} // namespace slvr
+
+#endif /* SLVR_PACKED_H_ */
@@ -0,0 +1,82 @@
+/**
+\file
+\brief Определение класса allocator::membuf_resource
+
+Заголовочный файл с определением класса allocator::membuf_resource - 
+реализации std::pmr::memory_resource поверх блока памяти membuf.
+Контейнеры std::pmr::vector, std::pmr::map и container::massive с 
+std::pmr::polymorphic_allocator могут размещаться в одном блоке, не 
+порождая отдельный тип аллокатора для каждого типа элементов.
+В режиме pooled освобожденные блоки переиспользуются через списки 
+размерных классов membuf, в режиме monotonic освобождение ничего не 
+делает, а вся память возвращается вместе с блоком.
+*/
+#ifndef SLVR_PMR_H_
+#define SLVR_PMR_H_
+
+#include <memory>
+#include <memory_resource>
+#include "slvr_allocator.h"
+
+namespace slvr
+{
+    namespace allocator
+    {
+        enum class resource_mode
+        {
+            monotonic,
+            pooled
+        };
+
+        class membuf_resource : public std::pmr::memory_resource
+        {
+        public:
+            /// Ресурс с собственным блоком памяти
+            explicit membuf_resource(resource_mode mode = resource_mode::pooled,
+                                     const arena_options &opts = arena_options{})
+                : m_owner(std::make_unique<membuf>(opts)), m_arena(m_owner.get()), m_mode(mode)
+            {
+            }
+
+            /// Ресурс поверх внешнего блока, например общего с superK
+            explicit membuf_resource(membuf &arena, resource_mode mode = resource_mode::pooled)
+                : m_arena(&arena), m_mode(mode)
+            {
+            }
+
+            membuf_resource(const membuf_resource &) = delete;
+            membuf_resource &operator=(const membuf_resource &) = delete;
+
+            membuf &arena() const noexcept { return *m_arena; }
+            resource_mode mode() const noexcept { return m_mode; }
+
+        protected:
+            void *do_allocate(std::size_t bytes, std::size_t alignment) override
+            {
+                return m_arena->place(1, bytes, alignment);
+            }
+
+            void do_deallocate(void *p, std::size_t bytes, std::size_t) override
+            {
+                if (m_mode == resource_mode::pooled)
+                    m_arena->clean(static_cast<char *>(p), 1, bytes);
+            }
+
+            bool do_is_equal(const std::pmr::memory_resource &other) const noexcept override
+            {
+                if (this == &other)
+                    return true;
+                auto that = dynamic_cast<const membuf_resource *>(&other);
+                return that && that->m_arena == m_arena && that->m_mode == m_mode;
+            }
+
+        private:
+            std::unique_ptr<membuf> m_owner;
+            membuf *m_arena;
+            resource_mode m_mode;
+        };
+
+    } // namespace allocator
+} // namespace slvr
+
+#endif /* SLVR_PMR_H_ */
@@ -0,0 +1,481 @@
+/**
+\file
+\brief Воспроизведение записанных размещений памяти на разных аллокаторах
+
+Заголовочный файл с форматом файла размещений и прогоном его на
+нескольких стратегиях распределения памяти. Последовательность
+allocate/deallocate/try_expand superK, записанная журналом
+trace::recorder (slvr_trace.h) реальной программой, переводится в
+операции replay::operation (from_events()) и сохраняется компактно:
+номера блоков не пишутся, а вычисляются по порядку размещения, числа
+кодируются переменной длиной (save(), load()). run() воспроизводит
+операции на аллокаторе и измеряет скорость, пиковый объем памяти,
+взятой у системы, и фрагментацию - долю этого объема сверх пика
+живых блоков. Содержимое блоков не трогается,
+поэтому время - это время самого аллокатора.
+*/
+#ifndef SLVR_REPLAY_H_
+#define SLVR_REPLAY_H_
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iterator>
+#include <memory_resource>
+#include <new>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#if defined(__GLIBC__)
+#include <malloc.h>
+#define SLVR_REPLAY_USABLE_SIZE 1
+#endif
+
+#include "slvr_allocator.h"
+#include "slvr_pmr.h"
+#include "slvr_trace.h"
+
+namespace slvr
+{
+    namespace replay
+    {
+        enum class op_kind : std::uint8_t
+        {
+            deallocate = 0,
+            allocate = 1,
+            resize = 2
+        };
+
+        /// Операция над блоком id; id - порядковый номер размещения блока
+        struct operation
+        {
+            op_kind kind;
+            std::uint32_t id;
+            /// Размер блока; для resize - новый размер
+            std::uint64_t bytes;
+            std::uint32_t alignment;
+        };
+
+        struct workload
+        {
+            std::vector<operation> ops;
+            std::uint32_t blocks = 0;
+            /// Пропущенные освобождения неизвестных блоков (from_events(); не сохраняется)
+            std::uint64_t unmatched = 0;
+        };
+
+        /**
+        Операции из журнала событий: allocate, deallocate и expand superK.
+        Освобождение блока, размещенного до начала записи или вытесненного
+        из кольца recorder, пропускается и считается в workload::unmatched.
+        */
+        inline workload from_events(const std::vector<trace::event> &events)
+        {
+            workload w;
+            std::unordered_map<const void *, std::uint32_t> live;
+            for (const trace::event &e : events)
+            {
+                if (e.what == trace::kind::allocate)
+                {
+                    live[e.address] = w.blocks;
+                    w.ops.push_back({op_kind::allocate, w.blocks++, e.bytes, std::max<std::uint32_t>(e.alignment, 1)});
+                }
+                else if (e.what == trace::kind::deallocate || e.what == trace::kind::expand)
+                {
+                    auto it = live.find(e.address);
+                    if (it == live.end())
+                    {
+                        ++w.unmatched;
+                        continue;
+                    }
+                    if (e.what == trace::kind::expand)
+                        w.ops.push_back({op_kind::resize, it->second, e.bytes, 0});
+                    else
+                    {
+                        w.ops.push_back({op_kind::deallocate, it->second, 0, 0});
+                        live.erase(it);
+                    }
+                }
+            }
+            return w;
+        }
+
+        namespace format
+        {
+            constexpr char magic[8] = {'S', 'L', 'V', 'R', 'T', 'R', 'C', '\0'};
+            constexpr std::uint32_t version = 1;
+
+            inline void put_varint(std::string &out, std::uint64_t v)
+            {
+                while (v >= 0x80)
+                {
+                    out += static_cast<char>((v & 0x7f) | 0x80);
+                    v >>= 7;
+                }
+                out += static_cast<char>(v);
+            }
+
+            inline std::uint64_t get_varint(const std::string &in, size_t &pos)
+            {
+                std::uint64_t v = 0;
+                for (unsigned shift = 0; shift < 64; shift += 7)
+                {
+                    if (pos >= in.size())
+                        throw std::runtime_error("allocation trace is truncated");
+                    auto byte = static_cast<unsigned char>(in[pos++]);
+                    v |= static_cast<std::uint64_t>(byte & 0x7f) << shift;
+                    if (!(byte & 0x80))
+                        return v;
+                }
+                throw std::runtime_error("allocation trace is corrupt");
+            }
+        } // namespace format
+
+        /**
+        Запись операций в файл path. Каждая операция - число переменной
+        длины (значение << 2 | вид): для allocate значение - размер, за ним
+        байт log2 выравнивания; для deallocate - номер блока; для resize -
+        номер блока, за ним новый размер. Ошибки - std::runtime_error.
+        */
+        inline void save(const workload &w, const std::string &path)
+        {
+            std::string body;
+            for (const operation &op : w.ops)
+            {
+                auto code = static_cast<std::uint64_t>(op.kind);
+                if (op.kind == op_kind::allocate)
+                {
+                    format::put_varint(body, op.bytes << 2 | code);
+                    unsigned shift = 0;
+                    while ((std::uint32_t(1) << shift) < op.alignment)
+                        ++shift;
+                    body += static_cast<char>(shift);
+                }
+                else
+                {
+                    format::put_varint(body, static_cast<std::uint64_t>(op.id) << 2 | code);
+                    if (op.kind == op_kind::resize)
+                        format::put_varint(body, op.bytes);
+                }
+            }
+            std::string head(format::magic, sizeof(format::magic));
+            format::put_varint(head, format::version);
+            format::put_varint(head, w.ops.size());
+            std::ofstream out(path, std::ios::binary | std::ios::trunc);
+            if (!out)
+                throw std::runtime_error("cannot create allocation trace " + path);
+            out.write(head.data(), static_cast<std::streamsize>(head.size()));
+            out.write(body.data(), static_cast<std::streamsize>(body.size()));
+            out.flush();
+            if (!out)
+                throw std::runtime_error("cannot write allocation trace " + path);
+        }
+
+        inline workload load(const std::string &path)
+        {
+            std::ifstream in(path, std::ios::binary);
+            if (!in)
+                throw std::runtime_error("cannot open allocation trace " + path);
+            std::string data((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+            if (data.size() < sizeof(format::magic) ||
+                std::memcmp(data.data(), format::magic, sizeof(format::magic)) != 0)
+                throw std::runtime_error("not an allocation trace " + path);
+            size_t pos = sizeof(format::magic);
+            if (format::get_varint(data, pos) != format::version)
+                throw std::runtime_error("unsupported allocation trace version " + path);
+            std::uint64_t count = format::get_varint(data, pos);
+            workload w;
+            w.ops.reserve(static_cast<size_t>(std::min<std::uint64_t>(count, data.size())));
+            std::vector<bool> alive;
+            for (std::uint64_t i = 0; i < count; ++i)
+            {
+                std::uint64_t v = format::get_varint(data, pos);
+                auto kind = static_cast<op_kind>(v & 3);
+                if (kind == op_kind::allocate)
+                {
+                    if (pos >= data.size() || static_cast<unsigned char>(data[pos]) > 31)
+                        throw std::runtime_error("allocation trace is corrupt " + path);
+                    auto alignment = std::uint32_t(1) << static_cast<unsigned char>(data[pos++]);
+                    w.ops.push_back({kind, w.blocks++, v >> 2, alignment});
+                    alive.push_back(true);
+                    continue;
+                }
+                if (kind != op_kind::deallocate && kind != op_kind::resize)
+                    throw std::runtime_error("allocation trace is corrupt " + path);
+                if ((v >> 2) >= w.blocks || !alive[static_cast<size_t>(v >> 2)])
+                    throw std::runtime_error("allocation trace refers to unknown block " + path);
+                operation op{kind, static_cast<std::uint32_t>(v >> 2), 0, 0};
+                if (kind == op_kind::deallocate)
+                    alive[op.id] = false;
+                if (kind == op_kind::resize)
+                    op.bytes = format::get_varint(data, pos);
+                w.ops.push_back(op);
+            }
+            return w;
+        }
+
+        /// Результат прогона операций на одном аллокаторе
+        struct result
+        {
+            std::string backend;
+            size_t operations = 0;
+            double seconds = 0;
+            double ops_per_second = 0;
+            /// Пик суммы размеров живых блоков
+            size_t peak_live_bytes = 0;
+            /// Пик памяти, взятой аллокатором у системы
+            size_t peak_footprint = 0;
+            /// 1 - peak_live_bytes / peak_footprint: доля пиковой памяти сверх пика живых блоков
+            double fragmentation = 0;
+        };
+
+        /**
+        Аллокаторы для run(): allocate(bytes, alignment), deallocate(p,
+        bytes, alignment), resize(p, old_bytes, new_bytes, alignment) -
+        новый адрес блока, footprint() - память, взятая у системы.
+        */
+        namespace backends
+        {
+            /// membuf без переиспользования: только сдвиг указателя (resource_mode::monotonic)
+            class bump
+            {
+            public:
+                static const char *name() { return "membuf bump"; }
+                void *allocate(size_t bytes, size_t alignment) { return arena.place(1, bytes, alignment); }
+                void deallocate(void *, size_t, size_t) {}
+                void *resize(void *p, size_t old_bytes, size_t new_bytes, size_t alignment)
+                {
+                    if (arena.expand(static_cast<char *>(p), old_bytes, new_bytes))
+                        return p;
+                    return allocate(new_bytes, alignment);
+                }
+                size_t footprint() const { return arena.reserved(); }
+
+            private:
+                allocator::membuf arena;
+            };
+
+            /// membuf со списками свободных блоков по размерным классам, как у superK
+            class free_list
+            {
+            public:
+                static const char *name() { return "membuf free lists"; }
+                void *allocate(size_t bytes, size_t alignment) { return arena.place(1, bytes, alignment); }
+                void deallocate(void *p, size_t bytes, size_t) { arena.clean(static_cast<char *>(p), 1, bytes); }
+                void *resize(void *p, size_t old_bytes, size_t new_bytes, size_t alignment)
+                {
+                    if (arena.expand(static_cast<char *>(p), old_bytes, new_bytes))
+                        return p;
+                    void *q = allocate(new_bytes, alignment);
+                    deallocate(p, old_bytes, alignment);
+                    return q;
+                }
+                size_t footprint() const { return arena.reserved(); }
+
+            private:
+                allocator::membuf arena;
+            };
+
+            /**
+            std::allocator (operator new). Объем памяти - блоки malloc живых
+            объектов с округлением и заголовком (malloc_usable_size); свободная
+            память внутри кучи malloc не учитывается. Где malloc_usable_size
+            нет - сумма запрошенных байт.
+            */
+            class standard
+            {
+            public:
+                static const char *name() { return "std::allocator"; }
+                void *allocate(size_t bytes, size_t alignment)
+                {
+                    void *p = ::operator new(bytes, std::align_val_t(alignment));
+                    held += block_size(p, bytes);
+                    return p;
+                }
+                void deallocate(void *p, size_t bytes, size_t alignment)
+                {
+                    held -= block_size(p, bytes);
+                    ::operator delete(p, bytes, std::align_val_t(alignment));
+                }
+                void *resize(void *p, size_t old_bytes, size_t new_bytes, size_t alignment)
+                {
+                    void *q = allocate(new_bytes, alignment);
+                    deallocate(p, old_bytes, alignment);
+                    return q;
+                }
+                size_t footprint() const { return held; }
+
+            private:
+                static size_t block_size(void *p, size_t bytes)
+                {
+#if defined(SLVR_REPLAY_USABLE_SIZE)
+                    (void)bytes;
+                    return ::malloc_usable_size(p) + sizeof(size_t);
+#else
+                    (void)p;
+                    return bytes;
+#endif
+                }
+
+                size_t held = 0;
+            };
+
+            /// Ресурс, считающий память, взятую у new_delete_resource
+            class counting_resource : public std::pmr::memory_resource
+            {
+            public:
+                size_t in_use() const noexcept { return bytes; }
+
+            protected:
+                void *do_allocate(size_t n, size_t alignment) override
+                {
+                    void *p = std::pmr::new_delete_resource()->allocate(n, alignment);
+                    bytes += n;
+                    return p;
+                }
+                void do_deallocate(void *p, size_t n, size_t alignment) override
+                {
+                    bytes -= n;
+                    std::pmr::new_delete_resource()->deallocate(p, n, alignment);
+                }
+                bool do_is_equal(const std::pmr::memory_resource &other) const noexcept override
+                {
+                    return this == &other;
+                }
+
+            private:
+                size_t bytes = 0;
+            };
+
+            /// std::pmr::unsynchronized_pool_resource поверх new_delete_resource
+            class pmr_pool
+            {
+            public:
+                pmr_pool() : pool(&upstream) {}
+                static const char *name() { return "pmr pool"; }
+                void *allocate(size_t bytes, size_t alignment) { return pool.allocate(bytes, alignment); }
+                void deallocate(void *p, size_t bytes, size_t alignment) { pool.deallocate(p, bytes, alignment); }
+                void *resize(void *p, size_t old_bytes, size_t new_bytes, size_t alignment)
+                {
+                    void *q = allocate(new_bytes, alignment);
+                    deallocate(p, old_bytes, alignment);
+                    return q;
+                }
+                size_t footprint() const { return upstream.in_use(); }
+
+            private:
+                counting_resource upstream;
+                std::pmr::unsynchronized_pool_resource pool;
+            };
+        } // namespace backends
+
+        namespace detail
+        {
+            /// Адреса и размеры блоков; создаются до аллокатора, чтобы не попасть в его замер
+            struct block_table
+            {
+                explicit block_table(size_t n) : blocks(n, nullptr), sizes(n, 0), aligns(n, 1) {}
+                std::vector<void *> blocks;
+                std::vector<std::uint64_t> sizes;
+                std::vector<std::uint32_t> aligns;
+            };
+
+            /// Один проход операций; measure - снимать объем памяти после каждой операции
+            template <typename Backend>
+            void replay_once(const workload &w, block_table &table, bool measure, result &r)
+            {
+                std::fill(table.blocks.begin(), table.blocks.end(), nullptr);
+                auto &blocks = table.blocks;
+                auto &sizes = table.sizes;
+                auto &aligns = table.aligns;
+                Backend backend;
+                size_t live = 0;
+                for (const operation &op : w.ops)
+                {
+                    switch (op.kind)
+                    {
+                    case op_kind::allocate:
+                        blocks[op.id] = backend.allocate(static_cast<size_t>(op.bytes), op.alignment);
+                        sizes[op.id] = op.bytes;
+                        aligns[op.id] = op.alignment;
+                        live += static_cast<size_t>(op.bytes);
+                        break;
+                    case op_kind::deallocate:
+                        backend.deallocate(blocks[op.id], static_cast<size_t>(sizes[op.id]), aligns[op.id]);
+                        live -= static_cast<size_t>(sizes[op.id]);
+                        blocks[op.id] = nullptr;
+                        break;
+                    case op_kind::resize:
+                        blocks[op.id] = backend.resize(blocks[op.id], static_cast<size_t>(sizes[op.id]),
+                                                       static_cast<size_t>(op.bytes), aligns[op.id]);
+                        live = live - static_cast<size_t>(sizes[op.id]) + static_cast<size_t>(op.bytes);
+                        sizes[op.id] = op.bytes;
+                        break;
+                    }
+                    if (measure)
+                    {
+                        r.peak_live_bytes = std::max(r.peak_live_bytes, live);
+                        r.peak_footprint = std::max(r.peak_footprint, backend.footprint());
+                    }
+                }
+                for (size_t id = 0; id < blocks.size(); ++id)
+                    if (blocks[id])
+                        backend.deallocate(blocks[id], static_cast<size_t>(sizes[id]), aligns[id]);
+                if (measure && r.peak_footprint)
+                    r.fragmentation = 1.0 - static_cast<double>(r.peak_live_bytes) / static_cast<double>(r.peak_footprint);
+            }
+        } // namespace detail
+
+        /**
+        Прогон операций на новом аллокаторе Backend: repeats проходов на
+        время и отдельный проход для объема памяти, чтобы его замер не
+        влиял на время.
+        */
+        template <typename Backend>
+        result run(const workload &w, int repeats = 1)
+        {
+            result r;
+            r.backend = Backend::name();
+            r.operations = w.ops.size();
+            detail::block_table table(w.blocks);
+            auto start = std::chrono::steady_clock::now();
+            for (int i = 0; i < repeats; ++i)
+                detail::replay_once<Backend>(w, table, false, r);
+            r.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() /
+                        std::max(repeats, 1);
+            r.ops_per_second = r.seconds > 0 ? static_cast<double>(r.operations) / r.seconds : 0;
+            detail::replay_once<Backend>(w, table, true, r);
+            return r;
+        }
+
+        /// Прогон на всех аллокаторах из backends
+        inline std::vector<result> run_all(const workload &w, int repeats = 1)
+        {
+            return {run<backends::standard>(w, repeats), run<backends::bump>(w, repeats),
+                    run<backends::free_list>(w, repeats), run<backends::pmr_pool>(w, repeats)};
+        }
+
+        /// Таблица результатов
+        inline void print(std::ostream &out, const std::vector<result> &results)
+        {
+            out << std::left << std::setw(20) << "backend" << std::right << std::setw(14) << "Mops/s"
+                << std::setw(16) << "peak live B" << std::setw(16) << "peak memory B" << std::setw(16)
+                << "fragmentation" << '\n';
+            for (const result &r : results)
+                out << std::left << std::setw(20) << r.backend << std::right << std::setw(14) << std::fixed
+                    << std::setprecision(2) << r.ops_per_second / 1e6 << std::setw(16) << r.peak_live_bytes
+                    << std::setw(16) << r.peak_footprint << std::setw(15) << std::setprecision(1)
+                    << r.fragmentation * 100 << "%\n";
+        }
+
+    } // namespace replay
+} // namespace slvr
+
+#endif /* SLVR_REPLAY_H_ */
@@ -0,0 +1,294 @@
+/**
+\file
+\brief Двоичные снимки container::massive
+
+Заголовочный файл с функцией container::save() и классом
+container::massive_view. save() записывает элементы massive в файл
+после заголовка (формат, порядок байт, тип и ширина элемента,
+количество, контрольная сумма). massive_view отображает такой файл
+в память через mmap и дает доступ к элементам только на чтение без
+копирования: загрузка сводится к отображению страниц, а данные
+читаются с диска по мере обращения. Для изменения данных снимок
+копируется в обычный massive с любым аллокатором (to_massive()).
+Контрольная сумма проверяется по запросу (verify()), так как для
+этого нужно прочитать весь файл.
+*/
+#ifndef SLVR_SNAPSHOT_H_
+#define SLVR_SNAPSHOT_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define SLVR_SNAPSHOT_MMAP 1
+#endif
+
+#include "slvr_container.h"
+
+namespace slvr
+{
+    namespace container
+    {
+        namespace snapshot
+        {
+            constexpr char magic[8] = {'S', 'L', 'V', 'R', 'M', 'S', 'V', '\0'};
+            constexpr std::uint32_t version = 1;
+            constexpr std::uint32_t byte_order_mark = 0x01020304;
+
+            /// Заголовок файла; данные начинаются сразу за ним, с границы 64 байт
+            struct header
+            {
+                char magic[8];
+                std::uint32_t version;
+                std::uint32_t byte_order;
+                std::uint32_t header_size;
+                std::uint32_t element_size;
+                std::uint32_t element_kind;
+                std::uint32_t reserved;
+                std::uint64_t count;
+                std::uint64_t checksum;
+                unsigned char padding[16];
+            };
+            static_assert(sizeof(header) == 64, "snapshot header must stay 64 bytes");
+
+            enum element_flags : std::uint32_t
+            {
+                is_signed = 1,
+                is_bool = 2
+            };
+
+            template <typename T>
+            constexpr std::uint32_t kind_of()
+            {
+                return (std::is_signed<T>::value ? is_signed : 0u) | (std::is_same<T, bool>::value ? is_bool : 0u);
+            }
+
+            /// 64-битная контрольная сумма по словам; хвост добивается нулями
+            inline std::uint64_t checksum(const void *data, std::size_t bytes)
+            {
+                const unsigned char *p = static_cast<const unsigned char *>(data);
+                std::uint64_t h = 0x9e3779b97f4a7c15ull ^ bytes;
+                std::size_t i = 0;
+                for (; i + 8 <= bytes; i += 8)
+                {
+                    std::uint64_t w;
+                    std::memcpy(&w, p + i, 8);
+                    h = (h ^ w) * 0x100000001b3ull;
+                    h ^= h >> 29;
+                }
+                if (i < bytes)
+                {
+                    std::uint64_t w = 0;
+                    std::memcpy(&w, p + i, bytes - i);
+                    h = (h ^ w) * 0x100000001b3ull;
+                    h ^= h >> 29;
+                }
+                return h;
+            }
+        } // namespace snapshot
+
+        /// Запись элементов arr в файл path; ошибки ввода-вывода - std::runtime_error
+        template <typename T, typename A, size_t N, typename P>
+        void save(const massive<T, A, N, P> &arr, const std::string &path)
+        {
+            static_assert(std::is_integral<T>::value, "snapshot stores integral values");
+            snapshot::header h{};
+            std::memcpy(h.magic, snapshot::magic, sizeof(h.magic));
+            h.version = snapshot::version;
+            h.byte_order = snapshot::byte_order_mark;
+            h.header_size = sizeof(snapshot::header);
+            h.element_size = sizeof(T);
+            h.element_kind = snapshot::kind_of<T>();
+            h.count = arr.size();
+            h.checksum = snapshot::checksum(arr.data(), arr.size() * sizeof(T));
+
+            std::ofstream out(path, std::ios::binary | std::ios::trunc);
+            if (!out)
+                throw std::runtime_error("cannot create snapshot " + path);
+            out.write(reinterpret_cast<const char *>(&h), sizeof(h));
+            out.write(reinterpret_cast<const char *>(arr.data()), static_cast<std::streamsize>(arr.size() * sizeof(T)));
+            out.flush();
+            if (!out)
+                throw std::runtime_error("cannot write snapshot " + path);
+        }
+
+        /**
+        Снимок massive<T>, отображенный в память только на чтение.
+        Заголовок проверяется при открытии: неверный формат, версия,
+        порядок байт, тип элемента или длина файла - std::runtime_error.
+        Где mmap недоступен, файл читается в память целиком.
+        */
+        template <typename T>
+        class massive_view
+        {
+            static_assert(std::is_integral<T>::value, "massive_view stores integral values");
+
+        public:
+            using value_type = T;
+            using const_pointer = const T *;
+            using const_reference = const T &;
+            using const_iterator = const T *;
+            using size_type = std::size_t;
+
+            explicit massive_view(const std::string &path)
+            {
+                open(path);
+                try
+                {
+                    check_header(path);
+                }
+                catch (...)
+                {
+                    close();
+                    throw;
+                }
+            }
+
+            massive_view(massive_view &&other) noexcept
+                : m_base(other.m_base), m_bytes(other.m_bytes), m_buffer(std::move(other.m_buffer))
+            {
+                other.m_base = nullptr;
+                other.m_bytes = 0;
+            }
+
+            massive_view &operator=(massive_view &&other) noexcept
+            {
+                if (this != &other)
+                {
+                    close();
+                    m_base = other.m_base;
+                    m_bytes = other.m_bytes;
+                    m_buffer = std::move(other.m_buffer);
+                    other.m_base = nullptr;
+                    other.m_bytes = 0;
+                }
+                return *this;
+            }
+
+            massive_view(const massive_view &) = delete;
+            massive_view &operator=(const massive_view &) = delete;
+
+            ~massive_view() { close(); }
+
+            /// Перемещенный снимок пуст: data() == nullptr, size() == 0
+            const T *data() const noexcept
+            {
+                return m_base ? reinterpret_cast<const T *>(m_base + sizeof(snapshot::header)) : nullptr;
+            }
+            size_t size() const noexcept { return m_base ? static_cast<size_t>(get_header().count) : 0; }
+            bool empty() const noexcept { return size() == 0; }
+            const_iterator begin() const noexcept { return data(); }
+            const_iterator end() const noexcept { return data() + size(); }
+            const_iterator cbegin() const noexcept { return begin(); }
+            const_iterator cend() const noexcept { return end(); }
+
+            const T &operator[](size_t i) const
+            {
+                if (i < size())
+                    return data()[i];
+                throw std::range_error("element number out of range");
+            }
+
+            /// Сверка контрольной суммы: читает весь снимок
+            bool verify() const
+            {
+                if (!m_base)
+                    return true;
+                return snapshot::checksum(data(), size() * sizeof(T)) == get_header().checksum;
+            }
+
+            /// Копия снимка в изменяемый massive с аллокатором alloc (например, superK)
+            template <typename M = massive<T>>
+            M to_massive(const typename M::allocator_type &alloc = typename M::allocator_type()) const
+            {
+                M result(alloc);
+                result.append(begin(), end());
+                return result;
+            }
+
+        private:
+            const snapshot::header &get_header() const noexcept
+            {
+                return *reinterpret_cast<const snapshot::header *>(m_base);
+            }
+
+            void open(const std::string &path)
+            {
+#if defined(SLVR_SNAPSHOT_MMAP)
+                int fd = ::open(path.c_str(), O_RDONLY);
+                if (fd < 0)
+                    throw std::runtime_error("cannot open snapshot " + path);
+                struct stat st;
+                if (::fstat(fd, &st) != 0 || static_cast<size_t>(st.st_size) < sizeof(snapshot::header))
+                {
+                    ::close(fd);
+                    throw std::runtime_error("snapshot too short " + path);
+                }
+                m_bytes = static_cast<size_t>(st.st_size);
+                void *p = ::mmap(nullptr, m_bytes, PROT_READ, MAP_PRIVATE, fd, 0);
+                ::close(fd);
+                if (p == MAP_FAILED)
+                    throw std::runtime_error("cannot map snapshot " + path);
+                m_base = static_cast<const unsigned char *>(p);
+#else
+                std::ifstream in(path, std::ios::binary | std::ios::ate);
+                if (!in)
+                    throw std::runtime_error("cannot open snapshot " + path);
+                m_bytes = static_cast<size_t>(in.tellg());
+                if (m_bytes < sizeof(snapshot::header))
+                    throw std::runtime_error("snapshot too short " + path);
+                m_buffer.resize((m_bytes + sizeof(std::uint64_t) - 1) / sizeof(std::uint64_t));
+                in.seekg(0);
+                in.read(reinterpret_cast<char *>(m_buffer.data()), static_cast<std::streamsize>(m_bytes));
+                if (!in)
+                    throw std::runtime_error("cannot read snapshot " + path);
+                m_base = reinterpret_cast<const unsigned char *>(m_buffer.data());
+#endif
+            }
+
+            void close() noexcept
+            {
+#if defined(SLVR_SNAPSHOT_MMAP)
+                if (m_base)
+                    ::munmap(const_cast<unsigned char *>(m_base), m_bytes);
+#endif
+                m_base = nullptr;
+                m_bytes = 0;
+                m_buffer.clear();
+            }
+
+            void check_header(const std::string &path) const
+            {
+                const snapshot::header &h = get_header();
+                if (std::memcmp(h.magic, snapshot::magic, sizeof(h.magic)) != 0)
+                    throw std::runtime_error("not a massive snapshot " + path);
+                if (h.version != snapshot::version || h.header_size != sizeof(snapshot::header))
+                    throw std::runtime_error("unsupported snapshot version " + path);
+                if (h.byte_order != snapshot::byte_order_mark)
+                    throw std::runtime_error("snapshot byte order differs " + path);
+                if (h.element_size != sizeof(T) || h.element_kind != snapshot::kind_of<T>())
+                    throw std::runtime_error("snapshot element type differs " + path);
+                if (h.count > (m_bytes - sizeof(snapshot::header)) / sizeof(T) ||
+                    m_bytes != sizeof(snapshot::header) + h.count * sizeof(T))
+                    throw std::runtime_error("snapshot size does not match header " + path);
+            }
+
+            const unsigned char *m_base = nullptr;
+            size_t m_bytes = 0;
+            std::vector<std::uint64_t> m_buffer;
+        };
+
+    } // namespace container
+} // namespace slvr
+
+#endif /* SLVR_SNAPSHOT_H_ */
@@ -0,0 +1,282 @@
+/**
+\file
+\brief Определение класса parallel::thread_pool
+
+Заголовочный файл с пулом потоков parallel::thread_pool и делением
+непрерывного массива на куски для параллельных алгоритмов massive.
+У каждого рабочего потока своя очередь задач: поток берет задачи с
+конца своей очереди, а закончив их, ворует с начала чужих. Вызывающий
+поток тоже выполняет задачи, пока не закончится его работа, поэтому
+вложенные вызовы из задач не блокируют пул. Пул thread_pool::shared()
+создается при первом обращении и общий для всех вызовов.
+*/
+#ifndef SLVR_THREAD_POOL_H_
+#define SLVR_THREAD_POOL_H_
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace slvr
+{
+    namespace parallel
+    {
+        /// Размер строки кэша, по которой выравниваются границы кусков
+        constexpr size_t cache_line = 64;
+        /// Минимум элементов в куске: меньшие куски не окупают передачу в другой поток
+        constexpr size_t min_grain = 4096;
+        /// Кусков на поток: запас для выравнивания нагрузки воровством
+        constexpr size_t chunks_per_thread = 4;
+
+        class thread_pool
+        {
+        public:
+            /// threads рабочих потоков; вызывающий поток работает вместе с ними
+            explicit thread_pool(size_t threads)
+                : queues(threads), queued(0), stop(false)
+            {
+                for (auto &q : queues)
+                    q = std::make_unique<task_queue>();
+                workers.reserve(threads);
+                for (size_t i = 0; i < threads; ++i)
+                    workers.emplace_back([this, i] { work(i); });
+            }
+
+            ~thread_pool()
+            {
+                {
+                    std::lock_guard<std::mutex> lock(sleep_mutex);
+                    stop = true;
+                }
+                wake.notify_all();
+                for (auto &w : workers)
+                    w.join();
+            }
+
+            thread_pool(const thread_pool &) = delete;
+            thread_pool &operator=(const thread_pool &) = delete;
+
+            /// Общий пул: по рабочему потоку на ядро, кроме ядра вызывающего потока
+            static thread_pool &shared()
+            {
+                static thread_pool pool(std::max(1u, std::thread::hardware_concurrency()) - 1);
+                return pool;
+            }
+
+            size_t size() const noexcept { return workers.size(); }
+            /// Потоков, выполняющих задачи вызова run(): рабочие и вызывающий
+            size_t concurrency() const noexcept { return workers.size() + 1; }
+
+            /**
+            Выполнение f(i) для i из [0, tasks) и ожидание всех задач.
+            Первое исключение из задач пробрасывается вызывающему.
+            */
+            template <typename F>
+            void run(size_t tasks, F &&f)
+            {
+                if (tasks == 0)
+                    return;
+                job<std::decay_t<F>> j(std::forward<F>(f), tasks);
+                if (queues.empty() || tasks == 1)
+                {
+                    for (size_t i = 0; i < tasks; ++i)
+                        j.execute(i);
+                }
+                else
+                {
+                    size_t home = current_queue();
+                    for (size_t i = 0; i < tasks; ++i)
+                        push((home + i) % queues.size(), task{&j, i});
+                    while (j.remaining.load(std::memory_order_acquire) != 0)
+                    {
+                        task t;
+                        if (take(home, t))
+                            t.owner->execute(t.index);
+                        else
+                            std::this_thread::yield();
+                    }
+                }
+                if (j.error)
+                    std::rethrow_exception(j.error);
+            }
+
+        private:
+            struct job_base
+            {
+                explicit job_base(size_t tasks) : remaining(tasks) {}
+                virtual ~job_base() = default;
+
+                void execute(size_t index)
+                {
+                    try
+                    {
+                        call(index);
+                    }
+                    catch (...)
+                    {
+                        std::lock_guard<std::mutex> lock(error_mutex);
+                        if (!error)
+                            error = std::current_exception();
+                    }
+                    remaining.fetch_sub(1, std::memory_order_release);
+                }
+                virtual void call(size_t index) = 0;
+
+                std::atomic<size_t> remaining;
+                std::mutex error_mutex;
+                std::exception_ptr error;
+            };
+
+            template <typename F>
+            struct job : job_base
+            {
+                job(F fn, size_t tasks) : job_base(tasks), f(std::move(fn)) {}
+                void call(size_t index) override { f(index); }
+                F f;
+            };
+
+            struct task
+            {
+                job_base *owner = nullptr;
+                size_t index = 0;
+            };
+
+            struct alignas(cache_line) task_queue
+            {
+                std::mutex m;
+                std::deque<task> tasks;
+            };
+
+            /// Номер очереди текущего потока: своя у рабочего, 0 у остальных
+            size_t current_queue() const
+            {
+                return self_pool() == this ? self_index() : 0;
+            }
+            static const thread_pool *&self_pool()
+            {
+                static thread_local const thread_pool *pool = nullptr;
+                return pool;
+            }
+            static size_t &self_index()
+            {
+                static thread_local size_t index = 0;
+                return index;
+            }
+
+            void push(size_t queue, task t)
+            {
+                {
+                    std::lock_guard<std::mutex> lock(queues[queue]->m);
+                    queues[queue]->tasks.push_back(t);
+                }
+                {
+                    std::lock_guard<std::mutex> lock(sleep_mutex);
+                    ++queued;
+                }
+                wake.notify_one();
+            }
+
+            /// Своя задача с конца очереди home, иначе украденная с начала чужой
+            bool take(size_t home, task &t)
+            {
+                for (size_t k = 0; k < queues.size(); ++k)
+                {
+                    task_queue &q = *queues[(home + k) % queues.size()];
+                    std::lock_guard<std::mutex> lock(q.m);
+                    if (q.tasks.empty())
+                        continue;
+                    if (k == 0)
+                    {
+                        t = q.tasks.back();
+                        q.tasks.pop_back();
+                    }
+                    else
+                    {
+                        t = q.tasks.front();
+                        q.tasks.pop_front();
+                    }
+                    std::lock_guard<std::mutex> sleep_lock(sleep_mutex);
+                    --queued;
+                    return true;
+                }
+                return false;
+            }
+
+            void work(size_t index)
+            {
+                self_pool() = this;
+                self_index() = index;
+                for (;;)
+                {
+                    task t;
+                    if (take(index, t))
+                    {
+                        t.owner->execute(t.index);
+                        continue;
+                    }
+                    std::unique_lock<std::mutex> lock(sleep_mutex);
+                    wake.wait_for(lock, std::chrono::milliseconds(100), [this] { return stop || queued != 0; });
+                    if (stop)
+                        return;
+                }
+            }
+
+            std::vector<std::unique_ptr<task_queue>> queues;
+            std::vector<std::thread> workers;
+            std::mutex sleep_mutex;
+            std::condition_variable wake;
+            size_t queued;
+            bool stop;
+        };
+
+        /**
+        Границы кусков массива data из n элементов для pool: не меньше
+        min_grain элементов в куске, до chunks_per_thread кусков на поток;
+        внутренние границы лежат на строках кэша, так что соседние куски
+        не делят строку.
+        */
+        template <typename T>
+        std::vector<size_t> chunk_bounds(const T *data, size_t n, const thread_pool &pool)
+        {
+            std::vector<size_t> bounds{0};
+            size_t chunks = std::min(pool.concurrency() * chunks_per_thread, (n + min_grain - 1) / min_grain);
+            if (chunks > 1 && cache_line % sizeof(T) == 0)
+            {
+                size_t line = cache_line / sizeof(T);
+                size_t len = (n / chunks + line - 1) / line * line;
+                size_t skew = (reinterpret_cast<std::uintptr_t>(data) % cache_line) / sizeof(T);
+                for (size_t b = len - skew; b < n; b += len)
+                    bounds.push_back(b);
+            }
+            else if (chunks > 1)
+            {
+                for (size_t i = 1; i < chunks; ++i)
+                    bounds.push_back(n / chunks * i);
+            }
+            bounds.push_back(n);
+            return bounds;
+        }
+
+        /// f(first, last) для каждого куска массива data на пуле pool
+        template <typename T, typename F>
+        void for_chunks(T *data, size_t n, thread_pool &pool, F &&f)
+        {
+            if (n == 0)
+                return;
+            std::vector<size_t> bounds = chunk_bounds(data, n, pool);
+            pool.run(bounds.size() - 1, [&](size_t i) { f(data + bounds[i], data + bounds[i + 1]); });
+        }
+
+    } // namespace parallel
+} // namespace slvr
+
+#endif /* SLVR_THREAD_POOL_H_ */
@@ -0,0 +1,367 @@
+/**
+\file
+\brief Запись событий аллокатора: trace::recorder
+
+Заголовочный файл с журналом событий размещения памяти. superK пишет
+в журнал allocate, deallocate, construct, destroy, try_expand и отказы
+(bad_alloc), massive - каждое изменение емкости (adjust_capacity).
+Событие - время, вид, тип элемента, число элементов, байты и адрес.
+У каждого потока свое кольцо фиксированного размера: запись идет без
+блокировок, при переполнении теряются самые старые события. Пока запись
+выключена (по умолчанию), цена обращения - одно чтение атомарного флага;
+с макросом SLVR_NO_TRACE обращения не компилируются совсем.
+Журнал сохраняется в формате Chrome trace (JSON), который открывают
+chrome://tracing и Perfetto: события всех потоков на одной шкале
+времени и счетчик живых байт.
+*/
+#ifndef SLVR_TRACE_H_
+#define SLVR_TRACE_H_
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+#include <typeinfo>
+#include <vector>
+
+#if defined(__has_include)
+#if __has_include(<cxxabi.h>)
+#include <cxxabi.h>
+#define SLVR_TRACE_DEMANGLE 1
+#endif
+#endif
+
+namespace slvr
+{
+    namespace trace
+    {
+        enum class kind : std::uint8_t
+        {
+            allocate,
+            deallocate,
+            construct,
+            destroy,
+            expand,
+            failure,
+            adjust_capacity
+        };
+
+        inline const char *kind_name(kind k)
+        {
+            switch (k)
+            {
+            case kind::allocate:
+                return "allocate";
+            case kind::deallocate:
+                return "deallocate";
+            case kind::construct:
+                return "construct";
+            case kind::destroy:
+                return "destroy";
+            case kind::expand:
+                return "expand";
+            case kind::failure:
+                return "failure";
+            case kind::adjust_capacity:
+                return "adjust_capacity";
+            }
+            return "unknown";
+        }
+
+        struct event
+        {
+            /// Наносекунды от создания recorder (первого обращения к global())
+            std::uint64_t time_ns;
+            const std::type_info *type;
+            const void *address;
+            /// Число элементов (для adjust_capacity и expand - новая емкость)
+            std::uint64_t count;
+            std::uint64_t bytes;
+            /// Для adjust_capacity и expand - прежняя емкость
+            std::uint64_t previous;
+            std::uint32_t thread;
+            kind what;
+            /// Выравнивание блока: alignof(T) или больше, если задано аллокатором
+            std::uint16_t alignment;
+        };
+
+        /// Записываются ли события: одно атомарное чтение на обращение
+        inline std::atomic<bool> tracing{false};
+
+        /// Маска видов событий для recorder::enable()
+        constexpr std::uint32_t bit(kind k) { return std::uint32_t(1) << static_cast<unsigned>(k); }
+        constexpr std::uint32_t all_kinds = ~std::uint32_t(0);
+        /// Размещения без construct/destroy - все, что нужно replay
+        constexpr std::uint32_t allocation_kinds =
+            bit(kind::allocate) | bit(kind::deallocate) | bit(kind::expand) | bit(kind::failure);
+
+        /**
+        Кольцо событий одного потока. Пишет только поток-владелец, без
+        блокировок; чтение (recorder::events()) рассчитано на то, что запись
+        в этот момент остановлена, иначе последние события могут быть неполными.
+        */
+        class ring
+        {
+        public:
+            ring(size_t capacity, std::uint32_t thread)
+                : slots(new event[capacity]), mask(capacity - 1), head(0), id(thread)
+            {
+            }
+
+            void push(const event &e) noexcept
+            {
+                std::uint64_t h = head.load(std::memory_order_relaxed);
+                slots[h & mask] = e;
+                slots[h & mask].thread = id;
+                head.store(h + 1, std::memory_order_release);
+            }
+
+            /// События в порядке записи, не больше емкости кольца
+            void copy_to(std::vector<event> &out) const
+            {
+                std::uint64_t h = head.load(std::memory_order_acquire);
+                std::uint64_t from = h > mask + 1 ? h - (mask + 1) : 0;
+                for (std::uint64_t i = from; i < h; ++i)
+                    out.push_back(slots[i & mask]);
+            }
+
+            std::uint64_t written() const noexcept { return head.load(std::memory_order_acquire); }
+            size_t capacity() const noexcept { return mask + 1; }
+            std::uint32_t thread() const noexcept { return id; }
+            /// Только при остановленной записи: иначе гонка с push() потока-владельца
+            void clear() noexcept { head.store(0, std::memory_order_release); }
+
+        private:
+            std::unique_ptr<event[]> slots;
+            std::uint64_t mask;
+            std::atomic<std::uint64_t> head;
+            std::uint32_t id;
+        };
+
+        class recorder
+        {
+        public:
+            /// Емкость кольца потока по умолчанию (степень двойки)
+            static constexpr size_t default_capacity = size_t(1) << 16;
+
+            static recorder &global()
+            {
+                static recorder r;
+                return r;
+            }
+
+            /**
+            Включение записи; capacity - емкость колец потоков, созданных после
+            вызова, kinds - маска записываемых видов событий (bit()).
+            */
+            void enable(size_t capacity = default_capacity, std::uint32_t kinds = all_kinds)
+            {
+                if (capacity == 0 || (capacity & (capacity - 1)))
+                    throw std::invalid_argument("trace ring capacity must be a power of two");
+                ring_capacity.store(capacity, std::memory_order_relaxed);
+                kind_mask.store(kinds, std::memory_order_relaxed);
+                tracing.store(true, std::memory_order_release);
+            }
+            void disable() { tracing.store(false, std::memory_order_release); }
+            bool enabled() const { return tracing.load(std::memory_order_relaxed); }
+
+            void record(kind what, const std::type_info &type, std::size_t alignment, std::uint64_t count,
+                        std::uint64_t bytes, const void *address, std::uint64_t previous = 0)
+            {
+                if (!(kind_mask.load(std::memory_order_relaxed) & bit(what)))
+                    return;
+                auto now = std::chrono::steady_clock::now() - epoch;
+                event e{static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(now).count()),
+                        &type, address, count, bytes, previous, 0, what, static_cast<std::uint16_t>(alignment)};
+                local().push(e);
+            }
+
+            /// События всех потоков по времени
+            std::vector<event> events() const
+            {
+                std::vector<event> result;
+                {
+                    std::lock_guard<std::mutex> lock(rings_mutex);
+                    for (auto &r : rings)
+                        r->copy_to(result);
+                }
+                std::stable_sort(result.begin(), result.end(),
+                                 [](const event &a, const event &b) { return a.time_ns < b.time_ns; });
+                return result;
+            }
+
+            /// События, вытесненные из колец при переполнении
+            std::uint64_t dropped() const
+            {
+                std::lock_guard<std::mutex> lock(rings_mutex);
+                std::uint64_t total = 0;
+                for (auto &r : rings)
+                    if (r->written() > r->capacity())
+                        total += r->written() - r->capacity();
+                return total;
+            }
+
+            /// Очистка колец; запись должна быть остановлена (disable()), как и для events()
+            void clear()
+            {
+                std::lock_guard<std::mutex> lock(rings_mutex);
+                for (auto &r : rings)
+                    r->clear();
+            }
+
+            /// Журнал в формате Chrome trace: мгновенные события и счетчик живых байт superK
+            void write_chrome_trace(std::ostream &out) const
+            {
+                std::vector<event> all = events();
+                out << "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[";
+                bool first = true;
+                auto separator = [&] {
+                    if (!first)
+                        out << ",\n";
+                    first = false;
+                };
+                std::vector<std::uint32_t> threads;
+                for (const event &e : all)
+                    if (std::find(threads.begin(), threads.end(), e.thread) == threads.end())
+                        threads.push_back(e.thread);
+                for (std::uint32_t t : threads)
+                {
+                    separator();
+                    out << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << t
+                        << ",\"args\":{\"name\":\"thread " << t << "\"}}";
+                }
+                long long live = 0;
+                for (const event &e : all)
+                {
+                    separator();
+                    out << "{\"name\":\"" << kind_name(e.what) << "\",\"cat\":\""
+                        << (e.what == kind::adjust_capacity ? "massive" : "superK")
+                        << "\",\"ph\":\"i\",\"s\":\"t\",\"pid\":1,\"tid\":" << e.thread << ",\"ts\":";
+                    write_us(out, e.time_ns);
+                    out << ",\"args\":{\"type\":\"" << escape(type_name(*e.type)) << "\",\"count\":" << e.count
+                        << ",\"bytes\":" << e.bytes << ",\"address\":\"" << e.address << "\"";
+                    if (e.what == kind::adjust_capacity || e.what == kind::expand)
+                        out << ",\"previous\":" << e.previous;
+                    out << "}}";
+                    long long change = 0;
+                    if (e.what == kind::allocate)
+                        change = static_cast<long long>(e.bytes);
+                    else if (e.what == kind::deallocate)
+                        change = -static_cast<long long>(e.bytes);
+                    else if (e.what == kind::expand)
+                        change = static_cast<long long>(e.bytes) -
+                                 static_cast<long long>(e.bytes / std::max<std::uint64_t>(e.count, 1) * e.previous);
+                    if (change)
+                    {
+                        live += change;
+                        separator();
+                        out << "{\"name\":\"live bytes\",\"ph\":\"C\",\"pid\":1,\"ts\":";
+                        write_us(out, e.time_ns);
+                        out << ",\"args\":{\"bytes\":" << live << "}}";
+                    }
+                }
+                out << "]}\n";
+            }
+
+            /// Сохранение журнала в файл path; ошибка записи - std::runtime_error
+            void save(const std::string &path) const
+            {
+                std::ofstream out(path, std::ios::trunc);
+                if (!out)
+                    throw std::runtime_error("cannot create trace " + path);
+                write_chrome_trace(out);
+                out.flush();
+                if (!out)
+                    throw std::runtime_error("cannot write trace " + path);
+            }
+
+            /// Читаемое имя типа
+            static std::string type_name(const std::type_info &type)
+            {
+#if defined(SLVR_TRACE_DEMANGLE)
+                int status = 0;
+                char *name = abi::__cxa_demangle(type.name(), nullptr, nullptr, &status);
+                if (status == 0 && name)
+                {
+                    std::string result(name);
+                    std::free(name);
+                    return result;
+                }
+                std::free(name);
+#endif
+                return type.name();
+            }
+
+        private:
+            recorder() : epoch(std::chrono::steady_clock::now()), ring_capacity(default_capacity), kind_mask(all_kinds) {}
+
+            /// Кольцо текущего потока; создается при первом событии потока
+            ring &local()
+            {
+                thread_local std::shared_ptr<ring> mine;
+                if (!mine)
+                {
+                    std::lock_guard<std::mutex> lock(rings_mutex);
+                    mine = std::make_shared<ring>(ring_capacity.load(std::memory_order_relaxed),
+                                                  static_cast<std::uint32_t>(rings.size() + 1));
+                    rings.push_back(mine);
+                }
+                return *mine;
+            }
+
+            static void write_us(std::ostream &out, std::uint64_t ns)
+            {
+                out << ns / 1000 << '.';
+                std::uint64_t frac = ns % 1000;
+                out << static_cast<char>('0' + frac / 100) << static_cast<char>('0' + frac / 10 % 10)
+                    << static_cast<char>('0' + frac % 10);
+            }
+
+            static std::string escape(const std::string &s)
+            {
+                std::string result;
+                for (char c : s)
+                {
+                    if (c == '"' || c == '\\')
+                        result += '\\';
+                    result += c;
+                }
+                return result;
+            }
+
+            std::chrono::steady_clock::time_point epoch;
+            std::atomic<size_t> ring_capacity;
+            std::atomic<std::uint32_t> kind_mask;
+            mutable std::mutex rings_mutex;
+            std::vector<std::shared_ptr<ring>> rings;
+        };
+
+        /// Событие для элементов типа T; ничего не делает, пока запись выключена
+        template <typename T>
+        inline void emit(kind what, std::size_t count, const void *address, std::size_t previous = 0,
+                         std::size_t alignment = alignof(T))
+        {
+#if !defined(SLVR_NO_TRACE)
+            if (tracing.load(std::memory_order_relaxed))
+                recorder::global().record(what, typeid(T), alignment, count, count * sizeof(T), address, previous);
+#else
+            (void)what;
+            (void)count;
+            (void)address;
+            (void)previous;
+            (void)alignment;
+#endif
+        }
+
+    } // namespace trace
+} // namespace slvr
+
+#endif /* SLVR_TRACE_H_ */
@@ -1,14 +1,45 @@
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
 #include <map>
+#include <string>
 #include <vector>
 #include "version.h"
 #include "slvr_allocator.h"
 #include "slvr_lib_factorial.h"
 #include "slvr_container.h"
+#include "slvr_replay.h"
 
 using namespace slvr::allocator;
 
-int main(int, char *[])
+/**
+allocator --record <файл> [--record-capacity <событий>]: размещения superK
+записываются для allocator_replay. Емкость кольца потока - степень двойки;
+если события вытеснены, неполная нагрузка не сохраняется.
+*/
+int main(int argc, char *argv[])
 {
+    std::string record_path;
+    size_t record_capacity = slvr::trace::recorder::default_capacity;
+    for (int i = 1; i + 1 < argc; ++i)
+    {
+        if (std::strcmp(argv[i], "--record") == 0)
+            record_path = argv[i + 1];
+        else if (std::strcmp(argv[i], "--record-capacity") == 0)
+            record_capacity = std::strtoull(argv[i + 1], nullptr, 10);
+    }
+    if (!record_path.empty())
+    {
+        try
+        {
+            slvr::trace::recorder::global().enable(record_capacity, slvr::trace::allocation_kinds);
+        }
+        catch (const std::invalid_argument &e)
+        {
+            std::cerr << e.what() << '\n';
+            return 2;
+        }
+    }
 
     using namespace slvr::lib;
     using namespace slvr::container;
@@ -50,5 +81,21 @@ int main(int, char *[])
         std::cout << el << '\n';
     std::cout << '\n';
 
+    if (!record_path.empty())
+    {
+        auto &rec = slvr::trace::recorder::global();
+        rec.disable();
+        if (rec.dropped() != 0)
+        {
+            std::cerr << rec.dropped() << " events were overwritten, nothing saved; raise --record-capacity\n";
+            return 1;
+        }
+        auto workload = slvr::replay::from_events(rec.events());
+        if (workload.unmatched != 0)
+            std::cerr << "warning: " << workload.unmatched << " operations on blocks allocated before recording skipped\n";
+        slvr::replay::save(workload, record_path);
+        std::cerr << workload.ops.size() << " operations recorded to " << record_path << '\n';
+    }
+
     return 0;
 }
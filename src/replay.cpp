@@ -0,0 +1,28 @@
+#include <algorithm>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include "slvr_replay.h"
+
+/// allocator_replay <файл> [повторы]: прогон записанных размещений на всех аллокаторах
+int main(int argc, char *argv[])
+{
+    if (argc < 2)
+    {
+        std::cerr << "usage: " << argv[0] << " <trace file> [repeats]\n";
+        return 2;
+    }
+    int repeats = argc > 2 ? std::max(1, std::atoi(argv[2])) : 1;
+    try
+    {
+        auto workload = slvr::replay::load(argv[1]);
+        std::cout << workload.ops.size() << " operations, " << workload.blocks << " blocks\n";
+        slvr::replay::print(std::cout, slvr::replay::run_all(workload, repeats));
+    }
+    catch (const std::exception &e)
+    {
+        std::cerr << e.what() << '\n';
+        return 1;
+    }
+    return 0;
+}
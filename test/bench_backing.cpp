@@ -0,0 +1,106 @@
+/**
+\file
+\brief Сравнение источников памяти membuf: std::aligned_alloc и mmap
+
+BM_first_touch создает блок и впервые записывает в каждую его страницу,
+то есть показывает стоимость первых обращений к свежей памяти.
+BM_steady_state размещает и освобождает блоки разного размера в уже 
+прогретом блоке. Аргумент - размер блока в мегабайтах.
+Запуск: ./bench --benchmark_filter=touch\|steady
+*/
+#include <benchmark/benchmark.h>
+#include <cstring>
+#include <vector>
+#include "slvr_allocator.h"
+
+namespace
+{
+    using slvr::allocator::arena_options;
+    using slvr::allocator::backing_store;
+    using slvr::allocator::membuf;
+
+    constexpr size_t touch_block = 4096;
+
+    arena_options make_options(backing_store backing, bool huge_pages, bool prefault, size_t bytes)
+    {
+        arena_options opts;
+        opts.initial_size = bytes;
+        opts.backing = backing;
+        opts.huge_pages = huge_pages;
+        opts.prefault = prefault;
+        return opts;
+    }
+
+    void first_touch(benchmark::State &state, backing_store backing, bool huge_pages, bool prefault)
+    {
+        size_t bytes = static_cast<size_t>(state.range(0)) << 20;
+        size_t blocks = bytes / touch_block - 1;
+        for (auto _ : state)
+        {
+            membuf arena(make_options(backing, huge_pages, prefault, bytes));
+            for (size_t i = 0; i < blocks; ++i)
+            {
+                char *p = arena.place(1, touch_block);
+                p[0] = static_cast<char>(i);
+                benchmark::DoNotOptimize(p);
+            }
+        }
+        state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * blocks * touch_block));
+    }
+
+    void steady_state(benchmark::State &state, backing_store backing, bool huge_pages)
+    {
+        size_t bytes = static_cast<size_t>(state.range(0)) << 20;
+        membuf arena(make_options(backing, huge_pages, false, bytes));
+        std::vector<char *> live(256);
+        std::vector<size_t> sizes(live.size());
+        for (size_t i = 0; i < live.size(); ++i)
+        {
+            sizes[i] = 16 + (i * 37) % 2048;
+            live[i] = arena.place(1, sizes[i]);
+        }
+        size_t i = 0;
+        for (auto _ : state)
+        {
+            size_t slot = (i * 7) % live.size();
+            arena.clean(live[slot], 1, sizes[slot]);
+            live[slot] = arena.place(1, sizes[slot]);
+            std::memset(live[slot], 1, sizes[slot]);
+            ++i;
+        }
+        state.SetItemsProcessed(static_cast<int64_t>(state.iterations()));
+    }
+
+    void BM_first_touch_heap(benchmark::State &state)
+    {
+        first_touch(state, backing_store::heap, false, false);
+    }
+    void BM_first_touch_mmap(benchmark::State &state)
+    {
+        first_touch(state, backing_store::mmap, false, false);
+    }
+    void BM_first_touch_mmap_prefault(benchmark::State &state)
+    {
+        first_touch(state, backing_store::mmap, false, true);
+    }
+    void BM_first_touch_mmap_huge(benchmark::State &state)
+    {
+        first_touch(state, backing_store::mmap, true, true);
+    }
+    void BM_steady_state_heap(benchmark::State &state)
+    {
+        steady_state(state, backing_store::heap, false);
+    }
+    void BM_steady_state_mmap_huge(benchmark::State &state)
+    {
+        steady_state(state, backing_store::mmap, true);
+    }
+
+} // namespace
+
+BENCHMARK(BM_first_touch_heap)->Arg(16)->Arg(64)->Unit(benchmark::kMicrosecond);
+BENCHMARK(BM_first_touch_mmap)->Arg(16)->Arg(64)->Unit(benchmark::kMicrosecond);
+BENCHMARK(BM_first_touch_mmap_prefault)->Arg(16)->Arg(64)->Unit(benchmark::kMicrosecond);
+BENCHMARK(BM_first_touch_mmap_huge)->Arg(16)->Arg(64)->Unit(benchmark::kMicrosecond);
+BENCHMARK(BM_steady_state_heap)->Arg(16);
+BENCHMARK(BM_steady_state_mmap_huge)->Arg(16);
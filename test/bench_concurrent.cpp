@@ -0,0 +1,53 @@
+/**
+\file
+\brief Замер пропускной способности superK в многопоточном режиме
+
+Каждый поток размещает и освобождает пачки объектов через 
+superK<T, concurrent>; для сравнения приводятся std::allocator и 
+однопоточный superK<T>. Запуск: ./bench --benchmark_filter=concurrent
+*/
+#include <benchmark/benchmark.h>
+#include <memory>
+#include <vector>
+#include "slvr_allocator.h"
+
+namespace
+{
+    constexpr int bench_batch = 16;
+
+    template <typename Alloc>
+    void alloc_free_batch(benchmark::State &state)
+    {
+        Alloc alloc;
+        std::vector<typename Alloc::value_type *> ptrs(bench_batch);
+        for (auto _ : state)
+        {
+            for (auto &p : ptrs)
+                p = alloc.allocate(1);
+            benchmark::DoNotOptimize(ptrs.data());
+            for (auto it = ptrs.rbegin(); it != ptrs.rend(); ++it)
+                alloc.deallocate(*it, 1);
+        }
+        state.SetItemsProcessed(state.iterations() * bench_batch);
+    }
+
+    void BM_std_allocator(benchmark::State &state)
+    {
+        alloc_free_batch<std::allocator<long>>(state);
+    }
+
+    void BM_superK_single(benchmark::State &state)
+    {
+        alloc_free_batch<slvr::allocator::superK<long>>(state);
+    }
+
+    void BM_superK_concurrent(benchmark::State &state)
+    {
+        alloc_free_batch<slvr::allocator::superK<long, slvr::allocator::concurrent>>(state);
+    }
+
+} // namespace
+
+BENCHMARK(BM_std_allocator)->ThreadRange(1, 8)->UseRealTime();
+BENCHMARK(BM_superK_single);
+BENCHMARK(BM_superK_concurrent)->ThreadRange(1, 8)->UseRealTime();
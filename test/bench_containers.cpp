@@ -0,0 +1,332 @@
+/**
+\file
+\brief Сравнение superK и container::massive со стандартными аналогами
+
+Для std::map, std::list, std::vector и container::massive замеряются 
+заполнение (поэлементное и одним вызовом), чередование размещения и освобождения (churn), обход и 
+разрушение контейнера с std::allocator и с superK на собственном блоке 
+памяти. Кроме времени на операцию выводятся счетчики:
+allocs_per_op - обращений к аллокатору на элемент,
+bytes_per_elem - пик запрошенной памяти на элемент,
+arena_bytes_per_elem - память блока membuf на элемент (только superK).
+Результаты для отслеживания регрессий: 
+./bench --benchmark_out=bench.json --benchmark_out_format=json
+*/
+#include <benchmark/benchmark.h>
+#include <list>
+#include <map>
+#include <memory>
+#include <type_traits>
+#include <vector>
+#include "slvr_allocator.h"
+#include "slvr_container.h"
+
+namespace
+{
+    struct alloc_counters
+    {
+        size_t allocations = 0;
+        size_t live_bytes = 0;
+        size_t peak_bytes = 0;
+        size_t arena_bytes = 0;
+
+        void reset() { *this = alloc_counters{}; }
+    };
+
+    alloc_counters &counters()
+    {
+        static alloc_counters c;
+        return c;
+    }
+
+    /// Аллокатор-обертка, считающая обращения к аллокатору A
+    template <typename A>
+    struct counted : A
+    {
+        using value_type = typename A::value_type;
+
+        template <typename U>
+        struct rebind
+        {
+            using other = counted<typename std::allocator_traits<A>::template rebind_alloc<U>>;
+        };
+
+        counted() = default;
+        explicit counted(const A &a) : A(a) {}
+        template <typename B>
+        counted(const counted<B> &other) : A(static_cast<const B &>(other)) {}
+
+        value_type *allocate(std::size_t n)
+        {
+            auto &c = counters();
+            ++c.allocations;
+            c.live_bytes += n * sizeof(value_type);
+            if (c.live_bytes > c.peak_bytes)
+                c.peak_bytes = c.live_bytes;
+            return A::allocate(n);
+        }
+
+        void deallocate(value_type *p, std::size_t n)
+        {
+            counters().live_bytes -= n * sizeof(value_type);
+            A::deallocate(p, n);
+        }
+
+        /// Рост блока на месте (massive) тоже учитывается в live_bytes
+        template <typename B = A>
+        auto try_expand(value_type *p, std::size_t old_n, std::size_t new_n)
+            -> decltype(std::declval<B &>().try_expand(p, old_n, new_n))
+        {
+            if (!A::try_expand(p, old_n, new_n))
+                return false;
+            auto &c = counters();
+            c.live_bytes = c.live_bytes - old_n * sizeof(value_type) + new_n * sizeof(value_type);
+            if (c.live_bytes > c.peak_bytes)
+                c.peak_bytes = c.live_bytes;
+            return true;
+        }
+
+        template <typename B>
+        bool operator==(const counted<B> &other) const
+        {
+            return static_cast<const A &>(*this) == static_cast<const B &>(other);
+        }
+        template <typename B>
+        bool operator!=(const counted<B> &other) const { return !(*this == other); }
+    };
+
+    template <typename T>
+    using std_alloc = counted<std::allocator<T>>;
+    template <typename T>
+    using arena_alloc = counted<slvr::allocator::superK<T>>;
+
+    template <typename A>
+    struct alloc_factory
+    {
+        static A make() { return A(); }
+        static void record(const A &) {}
+    };
+
+    template <typename T>
+    struct alloc_factory<arena_alloc<T>>
+    {
+        static arena_alloc<T> make()
+        {
+            return arena_alloc<T>(slvr::allocator::superK<T>::make_private());
+        }
+        static void record(const arena_alloc<T> &a)
+        {
+            auto stats = a.get_arena().get()->stats();
+            if (stats.reserved > counters().arena_bytes)
+                counters().arena_bytes = stats.reserved;
+        }
+    };
+
+    template <typename A>
+    using map_of = std::map<int, int, std::less<int>,
+                            typename std::allocator_traits<A>::template rebind_alloc<std::pair<const int, int>>>;
+    template <typename A>
+    using list_of = std::list<int, A>;
+    template <typename A>
+    using vector_of = std::vector<int, A>;
+    template <typename A>
+    using massive_of = slvr::container::massive<int, A>;
+
+    /// Операции нагрузки над контейнером C; value_of - значение элемента при обходе
+    template <typename C>
+    struct ops
+    {
+        static int value_of(int el) { return el; }
+        static void insert(C &c, int i) { c.push_back(i); }
+        static void bulk(C &c, const std::vector<int> &ids) { c.insert(c.end(), ids.begin(), ids.end()); }
+        static void churn(C &c, int i)
+        {
+            c.pop_back();
+            c.push_back(i);
+        }
+    };
+
+    template <typename A>
+    struct ops<std::map<int, int, std::less<int>, A>>
+    {
+        using C = std::map<int, int, std::less<int>, A>;
+        static int value_of(const typename C::value_type &el) { return el.first; }
+        static void insert(C &c, int i) { c.emplace(i, i); }
+        static void churn(C &c, int i)
+        {
+            c.erase(c.begin());
+            c.emplace(i, i);
+        }
+    };
+
+    template <typename A>
+    struct ops<std::list<int, A>>
+    {
+        static int value_of(int el) { return el; }
+        static void insert(std::list<int, A> &c, int i) { c.push_back(i); }
+        static void churn(std::list<int, A> &c, int i)
+        {
+            c.pop_front();
+            c.push_back(i);
+        }
+    };
+
+    template <typename A>
+    struct ops<slvr::container::massive<int, A>>
+    {
+        static int value_of(int el) { return el; }
+        static void insert(slvr::container::massive<int, A> &c, int i) { c.push_back(i); }
+        static void bulk(slvr::container::massive<int, A> &c, const std::vector<int> &ids)
+        {
+            c.append(ids.data(), ids.data() + ids.size());
+        }
+        static void churn(slvr::container::massive<int, A> &c, int i)
+        {
+            c.resize(c.size() - 1);
+            c.push_back(i);
+        }
+    };
+
+    template <typename C>
+    void fill(C &c, int n)
+    {
+        for (int i = 0; i < n; ++i)
+            ops<C>::insert(c, i);
+    }
+
+    void report(benchmark::State &state, int64_t ops_count)
+    {
+        auto &c = counters();
+        auto n = static_cast<double>(state.range(0));
+        state.SetItemsProcessed(ops_count);
+        state.counters["allocs_per_op"] =
+            ops_count ? static_cast<double>(c.allocations) / static_cast<double>(ops_count) : 0.0;
+        state.counters["bytes_per_elem"] = static_cast<double>(c.peak_bytes) / n;
+        if (c.arena_bytes)
+            state.counters["arena_bytes_per_elem"] = static_cast<double>(c.arena_bytes) / n;
+    }
+
+    template <template <typename> class Cont, typename A>
+    void BM_insert(benchmark::State &state)
+    {
+        using C = Cont<A>;
+        int n = static_cast<int>(state.range(0));
+        counters().reset();
+        for (auto _ : state)
+        {
+            auto alloc = alloc_factory<A>::make();
+            auto c = std::make_unique<C>(alloc);
+            fill(*c, n);
+            benchmark::DoNotOptimize(c.get());
+            state.PauseTiming();
+            alloc_factory<A>::record(alloc);
+            c.reset();
+            state.ResumeTiming();
+        }
+        report(state, state.iterations() * n);
+    }
+
+    /// Загрузка готового массива идентификаторов одним вызовом (append/insert)
+    template <template <typename> class Cont, typename A>
+    void BM_bulk_load(benchmark::State &state)
+    {
+        using C = Cont<A>;
+        int n = static_cast<int>(state.range(0));
+        std::vector<int> ids(static_cast<size_t>(n));
+        for (int i = 0; i < n; ++i)
+            ids[static_cast<size_t>(i)] = i;
+        counters().reset();
+        for (auto _ : state)
+        {
+            auto alloc = alloc_factory<A>::make();
+            auto c = std::make_unique<C>(alloc);
+            ops<C>::bulk(*c, ids);
+            benchmark::DoNotOptimize(c.get());
+            state.PauseTiming();
+            alloc_factory<A>::record(alloc);
+            c.reset();
+            state.ResumeTiming();
+        }
+        report(state, state.iterations() * n);
+    }
+
+    template <template <typename> class Cont, typename A>
+    void BM_churn(benchmark::State &state)
+    {
+        using C = Cont<A>;
+        int n = static_cast<int>(state.range(0));
+        counters().reset();
+        auto alloc = alloc_factory<A>::make();
+        C c(alloc);
+        fill(c, n);
+        counters().allocations = 0;
+        int i = n;
+        for (auto _ : state)
+            ops<C>::churn(c, i++);
+        alloc_factory<A>::record(alloc);
+        report(state, state.iterations());
+    }
+
+    template <template <typename> class Cont, typename A>
+    void BM_iterate(benchmark::State &state)
+    {
+        using C = Cont<A>;
+        int n = static_cast<int>(state.range(0));
+        counters().reset();
+        auto alloc = alloc_factory<A>::make();
+        C c(alloc);
+        fill(c, n);
+        counters().allocations = 0;
+        for (auto _ : state)
+        {
+            long long sum = 0;
+            for (auto &el : c)
+                sum += ops<C>::value_of(el);
+            benchmark::DoNotOptimize(sum);
+        }
+        alloc_factory<A>::record(alloc);
+        report(state, state.iterations() * n);
+    }
+
+    template <template <typename> class Cont, typename A>
+    void BM_teardown(benchmark::State &state)
+    {
+        using C = Cont<A>;
+        int n = static_cast<int>(state.range(0));
+        counters().reset();
+        for (auto _ : state)
+        {
+            state.PauseTiming();
+            auto alloc = alloc_factory<A>::make();
+            auto c = std::make_unique<C>(alloc);
+            fill(*c, n);
+            state.ResumeTiming();
+            c.reset();
+        }
+        report(state, state.iterations() * n);
+    }
+
+} // namespace
+
+#define SLVR_CONTAINER_BENCH(kind, cont)                                       \
+    BENCHMARK_TEMPLATE(kind, cont, std_alloc<int>)->RangeMultiplier(16)->Range(1 << 8, 1 << 16); \
+    BENCHMARK_TEMPLATE(kind, cont, arena_alloc<int>)->RangeMultiplier(16)->Range(1 << 8, 1 << 16)
+
+SLVR_CONTAINER_BENCH(BM_insert, map_of);
+SLVR_CONTAINER_BENCH(BM_insert, list_of);
+SLVR_CONTAINER_BENCH(BM_insert, vector_of);
+SLVR_CONTAINER_BENCH(BM_insert, massive_of);
+SLVR_CONTAINER_BENCH(BM_bulk_load, vector_of);
+SLVR_CONTAINER_BENCH(BM_bulk_load, massive_of);
+SLVR_CONTAINER_BENCH(BM_churn, map_of);
+SLVR_CONTAINER_BENCH(BM_churn, list_of);
+SLVR_CONTAINER_BENCH(BM_churn, vector_of);
+SLVR_CONTAINER_BENCH(BM_churn, massive_of);
+SLVR_CONTAINER_BENCH(BM_iterate, map_of);
+SLVR_CONTAINER_BENCH(BM_iterate, list_of);
+SLVR_CONTAINER_BENCH(BM_iterate, vector_of);
+SLVR_CONTAINER_BENCH(BM_iterate, massive_of);
+SLVR_CONTAINER_BENCH(BM_teardown, map_of);
+SLVR_CONTAINER_BENCH(BM_teardown, list_of);
+SLVR_CONTAINER_BENCH(BM_teardown, vector_of);
+SLVR_CONTAINER_BENCH(BM_teardown, massive_of);
@@ -0,0 +1,67 @@
+/**
+\file
+\brief Точный факториал: последовательное умножение против дерева произведений
+
+n! для n от 10^4 до 10^6. naive - умножение накопленного числа на
+очередной сомножитель в цикле (квадратичное время), tree - дерево
+произведений с Карацубой, parallel - то же на общем пуле
+parallel::thread_pool::shared(). Счетчик bits - длина результата.
+*/
+#include <benchmark/benchmark.h>
+#include <cstdint>
+#include "slvr_lib_bigint.h"
+
+namespace
+{
+    using slvr::lib::biguint;
+
+    void report(benchmark::State &state, const biguint &result)
+    {
+        state.SetItemsProcessed(static_cast<int64_t>(state.iterations()) * state.range(0));
+        state.counters["bits"] = static_cast<double>(result.bit_length());
+    }
+
+    void BM_factorial_naive(benchmark::State &state)
+    {
+        auto n = static_cast<std::uint32_t>(state.range(0));
+        biguint result;
+        for (auto _ : state)
+        {
+            result = biguint(1);
+            for (std::uint32_t i = 2; i <= n; ++i)
+                result *= i;
+            benchmark::DoNotOptimize(result.limbs().data());
+        }
+        report(state, result);
+    }
+
+    void BM_factorial_tree(benchmark::State &state)
+    {
+        auto n = static_cast<std::uint32_t>(state.range(0));
+        biguint result;
+        for (auto _ : state)
+        {
+            result = slvr::lib::big_factorial(n);
+            benchmark::DoNotOptimize(result.limbs().data());
+        }
+        report(state, result);
+    }
+
+    void BM_factorial_parallel(benchmark::State &state)
+    {
+        auto n = static_cast<std::uint32_t>(state.range(0));
+        auto &pool = slvr::parallel::thread_pool::shared();
+        biguint result;
+        for (auto _ : state)
+        {
+            result = slvr::lib::big_factorial(n, &pool);
+            benchmark::DoNotOptimize(result.limbs().data());
+        }
+        report(state, result);
+        state.counters["threads"] = static_cast<double>(pool.concurrency());
+    }
+} // namespace
+
+BENCHMARK(BM_factorial_naive)->RangeMultiplier(10)->Range(10000, 100000)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_factorial_tree)->RangeMultiplier(10)->Range(10000, 1000000)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_factorial_parallel)->RangeMultiplier(10)->Range(10000, 1000000)->Unit(benchmark::kMillisecond);
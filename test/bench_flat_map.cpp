@@ -0,0 +1,115 @@
+/**
+\file
+\brief flat_map против std::map на superK
+
+Словари int -> int на собственном блоке superK: std::map с узлом на 
+элемент (как в src/allocator.cpp) и flat_map на двух массивах massive.
+Замеряются поэлементная вставка случайных ключей, загрузка готового
+набора одним вызовом, поиск существующих ключей и обход. 
+arena_bytes_per_elem - память блока membuf на элемент.
+*/
+#include <benchmark/benchmark.h>
+#include <map>
+#include <random>
+#include <utility>
+#include <vector>
+#include "slvr_allocator.h"
+#include "slvr_flat_map.h"
+
+namespace
+{
+    using pair_alloc = slvr::allocator::superK<std::pair<const int, int>>;
+    using node_map = std::map<int, int, std::less<int>, pair_alloc>;
+    using flat = slvr::container::flat_map<int, int, std::less<int>, pair_alloc>;
+
+    std::vector<std::pair<int, int>> random_pairs(size_t n)
+    {
+        std::mt19937 gen(17);
+        std::vector<std::pair<int, int>> pairs(n);
+        for (auto &p : pairs)
+            p = {static_cast<int>(gen()), static_cast<int>(gen())};
+        return pairs;
+    }
+
+    size_t reserved(const pair_alloc &alloc) { return alloc.get_arena().get()->stats().reserved; }
+
+    void report(benchmark::State &state, size_t arena_bytes, size_t n, int64_t items)
+    {
+        state.SetItemsProcessed(items);
+        state.counters["arena_bytes_per_elem"] = static_cast<double>(arena_bytes) / static_cast<double>(n);
+    }
+
+    template <typename Map>
+    void BM_insert_each(benchmark::State &state)
+    {
+        auto pairs = random_pairs(static_cast<size_t>(state.range(0)));
+        size_t arena_bytes = 0;
+        for (auto _ : state)
+        {
+            pair_alloc alloc = pair_alloc::make_private();
+            Map m(alloc);
+            for (auto &p : pairs)
+                m.insert(p);
+            benchmark::DoNotOptimize(m.size());
+            arena_bytes = reserved(alloc);
+        }
+        report(state, arena_bytes, pairs.size(), static_cast<int64_t>(state.iterations() * pairs.size()));
+    }
+
+    template <typename Map>
+    void BM_bulk_build(benchmark::State &state)
+    {
+        auto pairs = random_pairs(static_cast<size_t>(state.range(0)));
+        size_t arena_bytes = 0;
+        for (auto _ : state)
+        {
+            pair_alloc alloc = pair_alloc::make_private();
+            Map m(pairs.begin(), pairs.end(), std::less<int>(), alloc);
+            benchmark::DoNotOptimize(m.size());
+            arena_bytes = reserved(alloc);
+        }
+        report(state, arena_bytes, pairs.size(), static_cast<int64_t>(state.iterations() * pairs.size()));
+    }
+
+    template <typename Map>
+    void BM_lookup(benchmark::State &state)
+    {
+        auto pairs = random_pairs(static_cast<size_t>(state.range(0)));
+        pair_alloc alloc = pair_alloc::make_private();
+        Map m(pairs.begin(), pairs.end(), std::less<int>(), alloc);
+        size_t i = 0;
+        for (auto _ : state)
+        {
+            benchmark::DoNotOptimize(m.find(pairs[i].first));
+            if (++i == pairs.size())
+                i = 0;
+        }
+        report(state, reserved(alloc), pairs.size(), static_cast<int64_t>(state.iterations()));
+    }
+
+    template <typename Map>
+    void BM_iterate(benchmark::State &state)
+    {
+        auto pairs = random_pairs(static_cast<size_t>(state.range(0)));
+        pair_alloc alloc = pair_alloc::make_private();
+        Map m(pairs.begin(), pairs.end(), std::less<int>(), alloc);
+        for (auto _ : state)
+        {
+            long long sum = 0;
+            for (auto kv : m)
+                sum += kv.second;
+            benchmark::DoNotOptimize(sum);
+        }
+        report(state, reserved(alloc), pairs.size(), static_cast<int64_t>(state.iterations() * m.size()));
+    }
+
+} // namespace
+
+#define SLVR_MAP_BENCH(kind)                                                  \
+    BENCHMARK_TEMPLATE(kind, node_map)->RangeMultiplier(16)->Range(1 << 8, 1 << 16); \
+    BENCHMARK_TEMPLATE(kind, flat)->RangeMultiplier(16)->Range(1 << 8, 1 << 16)
+
+SLVR_MAP_BENCH(BM_insert_each);
+SLVR_MAP_BENCH(BM_bulk_build);
+SLVR_MAP_BENCH(BM_lookup);
+SLVR_MAP_BENCH(BM_iterate);
@@ -0,0 +1,120 @@
+/**
+\file
+\brief Сравнение политик емкости massive
+
+Для каждой политики (classic_growth, double_growth, compact_growth, 
+sticky_growth) замеряется нагрузка: поэлементное заполнение до n, 
+уменьшение размера вдвое до n/64 и повторное заполнение до n.
+Кроме времени выводятся счетчики отдельного (не замеряемого) прохода:
+bytes_copied_per_elem - байт, перенесенных при смене буфера, на элемент;
+peak_bytes_per_elem - пик выделенной памяти на элемент;
+reallocs - число смен буфера.
+*/
+#include <benchmark/benchmark.h>
+#include <memory>
+#include "slvr_container.h"
+
+namespace
+{
+    size_t live_bytes = 0;
+    size_t peak_bytes = 0;
+
+    /// std::allocator с учетом пика выделенной памяти
+    template <typename T>
+    struct peak_alloc : std::allocator<T>
+    {
+        using value_type = T;
+
+        template <typename U>
+        struct rebind
+        {
+            using other = peak_alloc<U>;
+        };
+
+        peak_alloc() = default;
+        template <typename U>
+        peak_alloc(const peak_alloc<U> &) {}
+
+        T *allocate(std::size_t n)
+        {
+            live_bytes += n * sizeof(T);
+            if (live_bytes > peak_bytes)
+                peak_bytes = live_bytes;
+            return std::allocator<T>::allocate(n);
+        }
+        void deallocate(T *p, std::size_t n)
+        {
+            live_bytes -= n * sizeof(T);
+            std::allocator<T>::deallocate(p, n);
+        }
+    };
+
+    struct move_stats
+    {
+        size_t bytes_copied = 0;
+        size_t reallocs = 0;
+    };
+
+    /// Нагрузка; при stats != nullptr считаются переносы буфера
+    template <typename C>
+    void workload(C &c, size_t n, move_stats *stats)
+    {
+        auto track = [&](const int *before, size_t moved) {
+            if (stats && c.data() != before)
+            {
+                stats->bytes_copied += moved * sizeof(int);
+                ++stats->reallocs;
+            }
+        };
+        for (size_t i = 0; i < n; ++i)
+        {
+            const int *before = c.data();
+            size_t size = c.size();
+            c.push_back(static_cast<int>(i));
+            track(before, size);
+        }
+        while (c.size() > n / 64)
+        {
+            const int *before = c.data();
+            c.resize(c.size() / 2);
+            track(before, c.size());
+        }
+        while (c.size() < n)
+        {
+            const int *before = c.data();
+            size_t size = c.size();
+            c.push_back(0);
+            track(before, size);
+        }
+    }
+
+    template <typename Policy>
+    void BM_growth(benchmark::State &state)
+    {
+        using C = slvr::container::massive<int, peak_alloc<int>, 0, Policy>;
+        auto n = static_cast<size_t>(state.range(0));
+        for (auto _ : state)
+        {
+            C c;
+            workload(c, n, nullptr);
+            benchmark::DoNotOptimize(c.data());
+        }
+
+        move_stats stats;
+        live_bytes = peak_bytes = 0;
+        {
+            C c;
+            workload(c, n, &stats);
+        }
+        auto elems = static_cast<double>(n);
+        state.counters["bytes_copied_per_elem"] = static_cast<double>(stats.bytes_copied) / elems;
+        state.counters["peak_bytes_per_elem"] = static_cast<double>(peak_bytes) / elems;
+        state.counters["reallocs"] = static_cast<double>(stats.reallocs);
+    }
+
+} // namespace
+
+BENCHMARK_TEMPLATE(BM_growth, slvr::container::classic_growth)->RangeMultiplier(16)->Range(1 << 12, 1 << 20);
+BENCHMARK_TEMPLATE(BM_growth, slvr::container::double_growth)->RangeMultiplier(16)->Range(1 << 12, 1 << 20);
+BENCHMARK_TEMPLATE(BM_growth, slvr::container::compact_growth)->RangeMultiplier(16)->Range(1 << 12, 1 << 20);
+BENCHMARK_TEMPLATE(BM_growth, slvr::container::sticky_growth)->RangeMultiplier(16)->Range(1 << 12, 1 << 20);
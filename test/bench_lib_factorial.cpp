@@ -0,0 +1,104 @@
+/**
+\file
+\brief llfactorial: таблица против цикла
+
+loop - прежняя реализация llfactorial с циклом на каждый вызов,
+table - llfactorial из таблицы, построенной при компиляции. Аргументы
+перебираются по кругу 0..20, как при заполнении словарей в
+src/allocator.cpp. Отдельно замеряются binomial() и пакетный
+mod_factorials::binomial() против factorial_mod() на каждый вызов.
+*/
+#include <benchmark/benchmark.h>
+#include <cstdint>
+#include <utility>
+#include <vector>
+#include "slvr_lib_factorial.h"
+
+namespace
+{
+    long long loop_factorial(const int n)
+    {
+        long long res = 1;
+        for (int i = n < 0 ? -n : n; i > 0; i--)
+        {
+            long long temp = res;
+            res = res * i;
+            if (temp > res)
+                throw std::overflow_error("llfactorial function result is too big");
+        }
+        return res;
+    }
+
+    template <long long (*F)(int)>
+    void BM_llfactorial(benchmark::State &state)
+    {
+        int n = 0;
+        for (auto _ : state)
+        {
+            benchmark::DoNotOptimize(F(n));
+            n = n == 20 ? 0 : n + 1;
+        }
+        state.SetItemsProcessed(static_cast<int64_t>(state.iterations()));
+    }
+
+    void BM_binomial(benchmark::State &state)
+    {
+        unsigned n = 0, k = 0;
+        for (auto _ : state)
+        {
+            benchmark::DoNotOptimize(slvr::lib::binomial(n, k));
+            k = k == n ? 0 : k + 1;
+            n = k == 0 ? (n + 1) % 68 : n;
+        }
+        state.SetItemsProcessed(static_cast<int64_t>(state.iterations()));
+    }
+
+    constexpr unsigned long long prime = 1000000007;
+
+    std::vector<std::pair<unsigned, unsigned>> binomial_queries(size_t count, unsigned n_max)
+    {
+        std::vector<std::pair<unsigned, unsigned>> q(count);
+        for (size_t i = 0; i < count; ++i)
+        {
+            unsigned n = static_cast<unsigned>(i * 7919 % n_max);
+            q[i] = {n, static_cast<unsigned>(i * 104729 % (n + 1))};
+        }
+        return q;
+    }
+
+    void BM_binomial_mod_direct(benchmark::State &state)
+    {
+        auto q = binomial_queries(static_cast<size_t>(state.range(0)), 10000);
+        std::vector<unsigned long long> out(q.size());
+        for (auto _ : state)
+        {
+            // C(n, k) = n! / (k! (n - k)!) с обращением по малой теореме Ферма
+            for (size_t i = 0; i < q.size(); ++i)
+            {
+                slvr::lib::mod_factorials single(q[i].first, prime);
+                out[i] = single.binomial(q[i].first, q[i].second);
+            }
+            benchmark::DoNotOptimize(out.data());
+        }
+        state.SetItemsProcessed(static_cast<int64_t>(state.iterations()) * state.range(0));
+    }
+
+    void BM_binomial_mod_batched(benchmark::State &state)
+    {
+        auto q = binomial_queries(static_cast<size_t>(state.range(0)), 10000);
+        std::vector<unsigned long long> out(q.size());
+        for (auto _ : state)
+        {
+            slvr::lib::mod_factorials table(10000, prime);
+            table.binomial(q.begin(), q.end(), out.begin());
+            benchmark::DoNotOptimize(out.data());
+        }
+        state.SetItemsProcessed(static_cast<int64_t>(state.iterations()) * state.range(0));
+    }
+} // namespace
+
+BENCHMARK_TEMPLATE(BM_llfactorial, loop_factorial);
+BENCHMARK_TEMPLATE(BM_llfactorial, slvr::lib::llfactorial);
+BENCHMARK(BM_binomial);
+BENCHMARK(BM_binomial_mod_direct)->Arg(256);
+BENCHMARK(BM_binomial_mod_batched)->Arg(256)->Arg(65536);
@@ -0,0 +1,63 @@
+/**
+\file
+\brief Сжатый packed_massive против обычного massive
+
+Сумма 2^23 значений int64_t двух видов: небольшие случайные числа 
+(упаковка смещений) и возрастающие метки времени (дельта-кодирование).
+Выводятся скорость обхода и bytes_per_elem - занятая память на элемент.
+*/
+#include <benchmark/benchmark.h>
+#include <cstdint>
+#include <random>
+#include "slvr_container.h"
+#include "slvr_packed.h"
+
+namespace
+{
+    constexpr size_t elements = size_t(1) << 23;
+
+    enum data_kind
+    {
+        small_values,
+        timestamps
+    };
+
+    int64_t value_at(data_kind kind, std::mt19937_64 &gen, int64_t &stamp)
+    {
+        if (kind == small_values)
+            return static_cast<int64_t>(gen() % 5000);
+        return stamp += static_cast<int64_t>(gen() % 1000);
+    }
+
+    void BM_scan_plain(benchmark::State &state)
+    {
+        auto kind = static_cast<data_kind>(state.range(0));
+        slvr::container::massive<int64_t> arr;
+        std::mt19937_64 gen(9);
+        int64_t stamp = 1700000000000;
+        for (size_t i = 0; i < elements; ++i)
+            arr.push_back(value_at(kind, gen, stamp));
+        for (auto _ : state)
+            benchmark::DoNotOptimize(arr.sum());
+        state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * elements));
+        state.counters["bytes_per_elem"] = static_cast<double>(arr.capacity() * sizeof(int64_t)) / elements;
+    }
+
+    void BM_scan_packed(benchmark::State &state)
+    {
+        auto kind = static_cast<data_kind>(state.range(0));
+        slvr::container::packed_massive<int64_t> arr;
+        std::mt19937_64 gen(9);
+        int64_t stamp = 1700000000000;
+        for (size_t i = 0; i < elements; ++i)
+            arr.push_back(value_at(kind, gen, stamp));
+        for (auto _ : state)
+            benchmark::DoNotOptimize(arr.sum());
+        state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * elements));
+        state.counters["bytes_per_elem"] = static_cast<double>(arr.memory_bytes()) / elements;
+    }
+
+} // namespace
+
+BENCHMARK(BM_scan_plain)->Arg(small_values)->Arg(timestamps);
+BENCHMARK(BM_scan_packed)->Arg(small_values)->Arg(timestamps);
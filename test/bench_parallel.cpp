@@ -0,0 +1,84 @@
+/**
+\file
+\brief Масштабирование параллельных алгоритмов massive
+
+parallel_transform, parallel_reduce и parallel_sort над 
+massive<int64_t> из 2^24 элементов на пулах из 1..N потоков 
+(аргумент - число потоков, включая вызывающий; N - число ядер).
+Однопоточный вариант - тот же алгоритм на пуле без рабочих потоков.
+*/
+#include <benchmark/benchmark.h>
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <random>
+#include <thread>
+#include "slvr_container.h"
+
+namespace
+{
+    constexpr size_t elements = size_t(1) << 24;
+
+    slvr::container::massive<int64_t> &data()
+    {
+        static slvr::container::massive<int64_t> arr;
+        if (arr.size() == 0)
+        {
+            std::mt19937_64 gen(3);
+            arr.reserve(elements);
+            for (size_t i = 0; i < elements; ++i)
+                arr.push_back(static_cast<int64_t>(gen() >> 16));
+        }
+        return arr;
+    }
+
+    void BM_parallel_transform(benchmark::State &state)
+    {
+        slvr::parallel::thread_pool pool(static_cast<size_t>(state.range(0)) - 1);
+        auto &arr = data();
+        for (auto _ : state)
+        {
+            arr.parallel_transform([](int64_t x) { return x * 7 + 1; }, pool);
+            benchmark::ClobberMemory();
+        }
+        state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * elements));
+    }
+
+    void BM_parallel_reduce(benchmark::State &state)
+    {
+        slvr::parallel::thread_pool pool(static_cast<size_t>(state.range(0)) - 1);
+        const auto &arr = data();
+        for (auto _ : state)
+            benchmark::DoNotOptimize(arr.parallel_reduce(int64_t(0), std::plus<int64_t>(), pool));
+        state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * elements));
+    }
+
+    void BM_parallel_sort(benchmark::State &state)
+    {
+        slvr::parallel::thread_pool pool(static_cast<size_t>(state.range(0)) - 1);
+        auto &arr = data();
+        std::mt19937_64 gen(5);
+        for (auto _ : state)
+        {
+            state.PauseTiming();
+            std::generate(arr.begin(), arr.end(), [&gen] { return static_cast<int64_t>(gen() >> 16); });
+            state.ResumeTiming();
+            arr.parallel_sort(std::less<int64_t>(), pool);
+        }
+        state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * elements));
+    }
+
+    void thread_counts(benchmark::internal::Benchmark *b)
+    {
+        int cores = static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+        for (int threads = 1; threads < cores; threads *= 2)
+            b->Arg(threads);
+        b->Arg(cores);
+        b->UseRealTime();
+    }
+
+} // namespace
+
+BENCHMARK(BM_parallel_transform)->Apply(thread_counts);
+BENCHMARK(BM_parallel_reduce)->Apply(thread_counts);
+BENCHMARK(BM_parallel_sort)->Apply(thread_counts)->Unit(benchmark::kMillisecond);
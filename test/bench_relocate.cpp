@@ -0,0 +1,64 @@
+/**
+\file
+\brief Перенос элементов massive при росте буфера
+
+Поэлементное заполнение до n для POD-структуры (перенос одним memcpy),
+std::string и std::unique_ptr (перенос перемещением) в container::massive
+и в std::vector для сравнения. Время на элемент включает все смены буфера.
+*/
+#include <benchmark/benchmark.h>
+#include <memory>
+#include <string>
+#include <vector>
+#include "slvr_container.h"
+
+namespace
+{
+    struct particle
+    {
+        float position[3];
+        float velocity[3];
+        int id;
+    };
+
+    template <typename T>
+    T make(size_t i);
+
+    template <>
+    particle make<particle>(size_t i)
+    {
+        float f = static_cast<float>(i);
+        return particle{{f, f, f}, {1, 2, 3}, static_cast<int>(i)};
+    }
+    template <>
+    std::string make<std::string>(size_t i)
+    {
+        return std::string(24, static_cast<char>('a' + i % 26));
+    }
+    template <>
+    std::unique_ptr<int> make<std::unique_ptr<int>>(size_t i)
+    {
+        return std::make_unique<int>(static_cast<int>(i));
+    }
+
+    template <typename C>
+    void BM_fill(benchmark::State &state)
+    {
+        const size_t n = static_cast<size_t>(state.range(0));
+        for (auto _ : state)
+        {
+            C c;
+            for (size_t i = 0; i < n; ++i)
+                c.push_back(make<typename C::value_type>(i));
+            benchmark::DoNotOptimize(c.data());
+        }
+        state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * n));
+    }
+} // namespace
+
+BENCHMARK_TEMPLATE(BM_fill, slvr::container::massive<particle>)->Arg(1 << 16);
+BENCHMARK_TEMPLATE(BM_fill, std::vector<particle>)->Arg(1 << 16);
+BENCHMARK_TEMPLATE(BM_fill, slvr::container::massive<std::string>)->Arg(1 << 16);
+BENCHMARK_TEMPLATE(BM_fill, std::vector<std::string>)->Arg(1 << 16);
+BENCHMARK_TEMPLATE(BM_fill, slvr::container::massive<std::unique_ptr<int>>)->Arg(1 << 16);
+BENCHMARK_TEMPLATE(BM_fill, std::vector<std::unique_ptr<int>>)->Arg(1 << 16);
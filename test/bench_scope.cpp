@@ -0,0 +1,78 @@
+/**
+\file
+\brief Разбор данных запроса: поэлементное освобождение против arena_scope
+
+На каждый "запрос" строятся временные std::vector и std::map на superK
+одного блока membuf. destroy - контейнеры разрушаются как обычно, с
+destroy и deallocate на каждый элемент; scope - контейнеры создаются
+через arena_scope::create_unmanaged и освобождаются выходом из области.
+teardown_ns - время только разбора, в наносекундах на запрос.
+*/
+#include <benchmark/benchmark.h>
+#include <chrono>
+#include <map>
+#include <memory>
+#include <vector>
+#include "slvr_allocator.h"
+
+namespace
+{
+    using int_alloc = slvr::allocator::superK<int>;
+    using int_vector = std::vector<int, int_alloc>;
+    using int_map = std::map<int, int, std::less<int>, slvr::allocator::superK<std::pair<const int, int>>>;
+    using clock_type = std::chrono::steady_clock;
+
+    void fill(int_vector &v, int_map &m, int n)
+    {
+        for (int i = 0; i < n; ++i)
+        {
+            v.push_back(i);
+            m.emplace(i * 7919 % n, i);
+        }
+    }
+
+    void BM_request_destroy(benchmark::State &state)
+    {
+        slvr::allocator::membuf arena;
+        int_alloc alloc(arena);
+        int n = static_cast<int>(state.range(0));
+        double teardown = 0;
+        for (auto _ : state)
+        {
+            auto v = std::make_unique<int_vector>(alloc);
+            auto m = std::make_unique<int_map>(alloc);
+            fill(*v, *m, n);
+            benchmark::DoNotOptimize(m->size());
+            auto start = clock_type::now();
+            m.reset();
+            v.reset();
+            teardown += std::chrono::duration<double, std::nano>(clock_type::now() - start).count();
+        }
+        state.SetItemsProcessed(static_cast<int64_t>(state.iterations()) * n);
+        state.counters["teardown_ns"] = teardown / static_cast<double>(state.iterations());
+    }
+
+    void BM_request_scope(benchmark::State &state)
+    {
+        slvr::allocator::membuf arena;
+        int_alloc alloc(arena);
+        int n = static_cast<int>(state.range(0));
+        double teardown = 0;
+        for (auto _ : state)
+        {
+            slvr::allocator::arena_scope scope(arena);
+            auto &v = *scope.create_unmanaged<int_vector>(alloc);
+            auto &m = *scope.create_unmanaged<int_map>(alloc);
+            fill(v, m, n);
+            benchmark::DoNotOptimize(m.size());
+            auto start = clock_type::now();
+            scope.release();
+            teardown += std::chrono::duration<double, std::nano>(clock_type::now() - start).count();
+        }
+        state.SetItemsProcessed(static_cast<int64_t>(state.iterations()) * n);
+        state.counters["teardown_ns"] = teardown / static_cast<double>(state.iterations());
+    }
+} // namespace
+
+BENCHMARK(BM_request_destroy)->RangeMultiplier(16)->Range(64, 65536);
+BENCHMARK(BM_request_scope)->RangeMultiplier(16)->Range(64, 65536);
@@ -0,0 +1,81 @@
+/**
+\file
+\brief Загрузка massive из снимка против пересборки
+
+Старт с 2^22 элементами int64_t: пересборка push_back в цикле, 
+открытие снимка massive_view (отображение страниц) и копия снимка
+в massive на собственном блоке superK.
+*/
+#include <benchmark/benchmark.h>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include "slvr_allocator.h"
+#include "slvr_snapshot.h"
+
+namespace
+{
+    constexpr int64_t elements = int64_t(1) << 22;
+
+    /// Файл снимка в текущем каталоге, удаляется при завершении программы
+    struct snapshot_file
+    {
+        std::string path = "slvr_bench_snapshot.bin";
+
+        snapshot_file()
+        {
+            slvr::container::massive<int64_t> arr;
+            for (int64_t i = 0; i < elements; ++i)
+                arr.push_back(i);
+            slvr::container::save(arr, path);
+        }
+        ~snapshot_file() { std::remove(path.c_str()); }
+    };
+
+    const std::string &snapshot_path()
+    {
+        static snapshot_file file;
+        return file.path;
+    }
+
+    void BM_rebuild(benchmark::State &state)
+    {
+        for (auto _ : state)
+        {
+            slvr::container::massive<int64_t> arr;
+            for (int64_t i = 0; i < elements; ++i)
+                arr.push_back(i);
+            benchmark::DoNotOptimize(arr.data());
+        }
+        state.SetItemsProcessed(state.iterations() * elements);
+    }
+
+    void BM_open_view(benchmark::State &state)
+    {
+        const std::string &path = snapshot_path();
+        for (auto _ : state)
+        {
+            slvr::container::massive_view<int64_t> view(path);
+            benchmark::DoNotOptimize(view[view.size() - 1]);
+        }
+        state.SetItemsProcessed(state.iterations() * elements);
+    }
+
+    void BM_copy_to_arena(benchmark::State &state)
+    {
+        using arena_massive = slvr::container::massive<int64_t, slvr::allocator::superK<int64_t>>;
+        slvr::container::massive_view<int64_t> view(snapshot_path());
+        for (auto _ : state)
+        {
+            auto alloc = slvr::allocator::superK<int64_t>::make_private();
+            arena_massive arr = view.to_massive<arena_massive>(alloc);
+            benchmark::DoNotOptimize(arr.data());
+        }
+        state.SetItemsProcessed(state.iterations() * elements);
+    }
+
+} // namespace
+
+BENCHMARK(BM_rebuild)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_open_view)->Unit(benchmark::kMicrosecond);
+BENCHMARK(BM_copy_to_arena)->Unit(benchmark::kMillisecond);
@@ -0,0 +1,59 @@
+/**
+\file
+\brief Цена журнала событий trace::recorder
+
+Пары allocate/deallocate superK<long> и рост massive на superK при
+выключенной записи (off) и включенной (on). Разница off и замеров
+без журнала в других программах - чтение флага trace::tracing.
+*/
+#include <benchmark/benchmark.h>
+#include "slvr_allocator.h"
+#include "slvr_container.h"
+#include "slvr_trace.h"
+
+namespace
+{
+    void set_tracing(bool on)
+    {
+        auto &rec = slvr::trace::recorder::global();
+        if (on)
+            rec.enable();
+        else
+            rec.disable();
+    }
+
+    void BM_alloc_pair(benchmark::State &state)
+    {
+        set_tracing(state.range(0) != 0);
+        slvr::allocator::membuf arena;
+        slvr::allocator::superK<long> alloc(arena);
+        for (auto _ : state)
+        {
+            long *p = alloc.allocate(4);
+            benchmark::DoNotOptimize(p);
+            alloc.deallocate(p, 4);
+        }
+        set_tracing(false);
+        slvr::trace::recorder::global().clear();
+        state.SetItemsProcessed(static_cast<int64_t>(state.iterations()));
+    }
+
+    void BM_massive_growth(benchmark::State &state)
+    {
+        set_tracing(state.range(0) != 0);
+        for (auto _ : state)
+        {
+            slvr::container::massive<int, slvr::allocator::superK<int>> arr(
+                slvr::allocator::superK<int>::make_private());
+            for (int i = 0; i < 4096; ++i)
+                arr.push_back(i);
+            benchmark::DoNotOptimize(arr.data());
+        }
+        set_tracing(false);
+        slvr::trace::recorder::global().clear();
+        state.SetItemsProcessed(static_cast<int64_t>(state.iterations()) * 4096);
+    }
+} // namespace
+
+BENCHMARK(BM_alloc_pair)->ArgName("tracing")->Arg(0)->Arg(1);
+BENCHMARK(BM_massive_growth)->ArgName("tracing")->Arg(0)->Arg(1);
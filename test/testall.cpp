@@ -1,13 +1,35 @@
 #define UNUSED(a) (void)a
-// #define DEBUG
 
 #include "version.h"
 #include <gtest/gtest.h>
 #include <iostream>
+#include <limits>
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <map>
+#include <memory_resource>
+#include <mutex>
+#include <numeric>
+#include <random>
+#include <set>
+#include <sstream>
 #include <string>
+#include <thread>
+#include <vector>
 #include "slvr_lib_factorial.h"
+#include "slvr_lib_bigint.h"
 #include "slvr_allocator.h"
 #include "slvr_container.h"
+#include "slvr_flat_map.h"
+#include "slvr_packed.h"
+#include "slvr_pmr.h"
+#include "slvr_replay.h"
+#include "slvr_snapshot.h"
+#include "slvr_thread_pool.h"
+#include "slvr_trace.h"
 
 TEST(version, version_test)
 {
@@ -33,6 +55,104 @@ TEST(lib_factorial, total)
     EXPECT_EQ(3628800, fn_result_from_10);
 }
 
+TEST(lib_factorial, tables)
+{
+    using namespace slvr::lib;
+    static_assert(max_factorial<long long>() == 20, "20! is the last long long factorial");
+    static_assert(max_factorial<uint128>() == 34, "34! is the last 128-bit factorial");
+    static_assert(factorial_table<long long>[20] == 2432902008176640000LL, "20!");
+    static_assert(checked_factorial<unsigned>(12) == 479001600u, "12!");
+
+    EXPECT_EQ(120, llfactorial(-5));
+    EXPECT_EQ(2432902008176640000LL, llfactorial(20));
+    EXPECT_THROW(llfactorial(std::numeric_limits<int>::min()), std::overflow_error);
+    EXPECT_THROW(checked_factorial<unsigned>(13), std::overflow_error);
+    uint128 f34 = u128factorial(34);
+    EXPECT_TRUE(u128factorial(33) * 34 == f34);
+    EXPECT_EQ("295232799039604140847618609643520000000", big_factorial(34).to_string());
+    uint128 from_limbs = 0;
+    for (size_t i = big_factorial(34).limbs().size(); i-- > 0;)
+        from_limbs = from_limbs << 32 | big_factorial(34).limbs()[i];
+    EXPECT_TRUE(f34 == from_limbs);
+    EXPECT_THROW(u128factorial(35), std::overflow_error);
+
+    EXPECT_EQ(0u, binomial(3, 4));
+    EXPECT_EQ(252u, binomial(10, 5));
+    EXPECT_EQ(14226520737620288370ull, binomial(67, 33));
+    EXPECT_THROW(binomial(68, 34), std::overflow_error);
+    EXPECT_EQ(4950u, binomial(100, 2));
+    EXPECT_THROW(binomial(100, 50), std::overflow_error);
+
+    const unsigned long long p = 1000000007;
+    mod_factorials table(1000, p);
+    EXPECT_EQ(factorial_mod(1000, p), table.factorial(1000));
+    EXPECT_EQ(static_cast<unsigned long long>(llfactorial(20) % static_cast<long long>(p)), table.factorial(20));
+    EXPECT_EQ(binomial(60, 30) % p, table.binomial(60, 30));
+    EXPECT_EQ(0u, factorial_mod(20, 7));
+
+    // Теорема Люка: C(n, k) mod 7 для n >= 7
+    mod_factorials small(100, 7);
+    EXPECT_EQ(6u, small.n_max());
+    std::vector<std::pair<unsigned, unsigned>> pairs{{10, 3}, {50, 20}, {49, 7}, {6, 7}};
+    std::vector<unsigned long long> out(pairs.size());
+    small.binomial(pairs.begin(), pairs.end(), out.begin());
+    for (size_t i = 0; i < pairs.size(); ++i)
+        EXPECT_EQ(binomial(pairs[i].first, pairs[i].second) % 7, out[i]);
+}
+
+TEST(lib_factorial, big_factorial)
+{
+    using slvr::lib::biguint;
+    EXPECT_EQ("1", slvr::lib::big_factorial(0).to_string());
+    EXPECT_EQ("3628800", slvr::lib::big_factorial(10).to_string());
+    EXPECT_EQ("15511210043330985984000000", slvr::lib::big_factorial(25).to_string());
+    std::string f100 = slvr::lib::big_factorial(100).to_string();
+    EXPECT_EQ(158u, f100.size());
+    EXPECT_EQ("93326215443944152681", f100.substr(0, 20));
+    EXPECT_EQ(std::string(24, '0'), f100.substr(f100.size() - 24));
+
+    // Дерево произведений (с Карацубой) против последовательного умножения
+    for (std::uint32_t n : {1000u, 5000u})
+    {
+        biguint naive(1);
+        for (std::uint32_t i = 2; i <= n; ++i)
+            naive *= i;
+        EXPECT_EQ(naive, slvr::lib::big_factorial(n));
+        slvr::parallel::thread_pool pool(3);
+        EXPECT_EQ(naive, slvr::lib::big_factorial(n, &pool));
+    }
+
+    // Отрезок до 2^32: граница диапазона не помещается в 32 бита
+    {
+        size_t twos = 0, naive_twos = 0;
+        biguint naive(1);
+        for (std::uint64_t i = 0xffffffc0u; i <= 0xffffffffu; ++i)
+            naive *= slvr::lib::detail::odd_part(static_cast<std::uint32_t>(i), naive_twos);
+        EXPECT_EQ(naive, slvr::lib::detail::odd_product(0xffffffc0u, std::uint64_t(1) << 32, twos, nullptr));
+        EXPECT_EQ(naive_twos, twos);
+    }
+
+    // Карацуба на длинных сомножителях разной длины
+    std::mt19937 gen(5);
+    biguint a(1), b(1);
+    for (int i = 0; i < 6000; ++i)
+        a *= gen() | 1u;
+    for (int i = 0; i < 4500; ++i)
+        b *= gen() | 1u;
+    biguint product = a * b;
+    size_t bits = a.bit_length() + b.bit_length();
+    EXPECT_TRUE(product.bit_length() == bits || product.bit_length() == bits - 1);
+    biguint check = a;
+    gen.seed(5);
+    for (int i = 0; i < 6000; ++i)
+        gen();
+    for (int i = 0; i < 4500; ++i)
+        check *= gen() | 1u;
+    EXPECT_EQ(check, product);
+    slvr::parallel::thread_pool pool(3);
+    EXPECT_EQ(check, biguint::multiply(a, b, &pool));
+}
+
 TEST(allocator, total)
 {
     struct char4
@@ -82,10 +202,10 @@ TEST(allocator, total)
     EXPECT_EQ(15, sum_i);
     EXPECT_STRCASEEQ("axyzbxyzcxyzdxyzexyzfxyz", str_result.c_str());
 
-    EXPECT_EQ(1024 / sizeof(long), test_allocator_l.get_limit());
-    EXPECT_EQ(1024 / sizeof(int), test_allocator_i.get_limit());
-    EXPECT_EQ(1024 / sizeof(char), test_allocator_c.max_size());
-    EXPECT_EQ(1024 / sizeof(char4), test_allocator_obj.max_size());
+    EXPECT_EQ(std::numeric_limits<size_t>::max() / sizeof(long), test_allocator_l.get_limit());
+    EXPECT_EQ(std::numeric_limits<size_t>::max() / sizeof(int), test_allocator_i.get_limit());
+    EXPECT_EQ(std::numeric_limits<size_t>::max() / sizeof(char), test_allocator_c.max_size());
+    EXPECT_EQ(std::numeric_limits<size_t>::max() / sizeof(char4), test_allocator_obj.max_size());
 
     EXPECT_THROW(test_allocator_l.set_limit(5), std::logic_error);
     EXPECT_THROW(test_allocator_i.set_limit(5), std::logic_error);
@@ -139,6 +259,7 @@ TEST(allocator, total)
     test_allocator_l.deallocate(palloc_l2, 6);
     test_allocator_obj.deallocate(palloc_obj, 6);
 
+    test_allocator_l.set_limit(1024 / sizeof(long));
     int max_n_long = test_allocator_l.max_size();
     EXPECT_NO_THROW(palloc_l = test_allocator_l.allocate(max_n_long));
     for (int i = 0; i < max_n_long; ++i)
@@ -147,6 +268,1326 @@ TEST(allocator, total)
     for (int i = max_n_long; i >= 0; --i)
         test_allocator_l.destroy(palloc_l + i);
     test_allocator_l.deallocate(palloc_l, max_n_long);
+    test_allocator_l.set_limit(0);
+}
+
+TEST(allocator, growing_arena)
+{
+    slvr::allocator::membuf arena(slvr::allocator::arena_options{64, 2});
+    EXPECT_EQ(1u, arena.chunks());
+
+    std::vector<long *> blocks;
+    for (long i = 0; i < 200; ++i)
+    {
+        auto p = reinterpret_cast<long *>(arena.place(3, sizeof(long)));
+        p[0] = i;
+        p[2] = -i;
+        blocks.push_back(p);
+    }
+    EXPECT_LT(1u, arena.chunks());
+    EXPECT_LE(200 * 3 * sizeof(long), arena.reserved());
+    for (long i = 0; i < 200; ++i)
+    {
+        EXPECT_EQ(i, blocks[i][0]);
+        EXPECT_EQ(-i, blocks[i][2]);
+    }
+    for (auto p : blocks)
+        arena.clean(reinterpret_cast<char *>(p), 3, sizeof(long));
+    EXPECT_EQ(1u, arena.chunks());
+
+    std::map<int, long, std::less<int>, slvr::allocator::superK<std::pair<const int, long>>> big;
+    for (int i = 0; i < 10000; ++i)
+        big[i] = i;
+    EXPECT_EQ(10000u, big.size());
+    EXPECT_EQ(9999, big[9999]);
+}
+
+TEST(allocator, free_lists)
+{
+    using node_map = std::map<int, int, std::less<int>,
+                              slvr::allocator::superK<std::pair<const int, int>>>;
+    node_map m;
+    for (int round = 0; round < 200; ++round)
+    {
+        for (int i = 0; i < 8; ++i)
+            m[(round * 7 + i * 3) % 16] = i;
+        EXPECT_NO_THROW(m.erase(m.begin()));
+        EXPECT_NO_THROW(m.erase(std::prev(m.end())));
+        for (int i = 0; i < 16; i += 2)
+            m.erase(i);
+    }
+    m.clear();
+
+    slvr::allocator::superK<long> alloc_l;
+    auto p1 = alloc_l.allocate(4);
+    auto p2 = alloc_l.allocate(4);
+    alloc_l.deallocate(p1, 4);
+    auto p3 = alloc_l.allocate(4);
+    EXPECT_EQ(p1, p3);
+    alloc_l.deallocate(p2, 4);
+    alloc_l.deallocate(p3, 4);
+
+    EXPECT_EQ(8u, slvr::allocator::class_size(slvr::allocator::size_class(1)));
+    EXPECT_EQ(512u, slvr::allocator::class_size(slvr::allocator::size_class(512)));
+    EXPECT_EQ(640u, slvr::allocator::class_size(slvr::allocator::size_class(513)));
+    EXPECT_EQ(1024u, slvr::allocator::class_size(slvr::allocator::size_class(1024)));
+}
+
+TEST(allocator, concurrent_stress)
+{
+    using alloc_t = slvr::allocator::superK<long, slvr::allocator::concurrent>;
+    constexpr int threads_count = 4;
+    constexpr int rounds = 2000;
+    constexpr int batch = 8;
+
+    std::mutex mtx;
+    std::vector<std::vector<long *>> mailboxes(threads_count);
+    std::vector<std::atomic<int>> outstanding(threads_count);
+    std::atomic<int> finished{0};
+    std::atomic<long> checksum{0};
+
+    auto worker = [&](int id) {
+        alloc_t alloc;
+        long local_sum = 0;
+        auto receive = [&]() {
+            std::vector<long *> incoming;
+            {
+                std::lock_guard<std::mutex> lock(mtx);
+                incoming.swap(mailboxes[id]);
+            }
+            for (auto p : incoming)
+            {
+                local_sum += *p;
+                --outstanding[*p / rounds];
+                alloc.destroy(p);
+                alloc.deallocate(p, 1);
+            }
+        };
+        for (int round = 0; round < rounds; ++round)
+        {
+            while (outstanding[id] > 2 * batch)
+            {
+                receive();
+                std::this_thread::yield();
+            }
+            std::vector<long *> outgoing;
+            for (int i = 0; i < batch; ++i)
+            {
+                auto p = alloc.allocate(1);
+                alloc.construct(p, static_cast<long>(id * rounds + round));
+                outgoing.push_back(p);
+            }
+            outstanding[id] += batch;
+            {
+                std::lock_guard<std::mutex> lock(mtx);
+                auto &next = mailboxes[(id + 1) % threads_count];
+                next.insert(next.end(), outgoing.begin(), outgoing.end());
+            }
+            receive();
+        }
+        ++finished;
+        while (finished < threads_count)
+        {
+            receive();
+            std::this_thread::yield();
+        }
+        checksum += local_sum;
+    };
+
+    std::vector<std::thread> pool;
+    for (int id = 0; id < threads_count; ++id)
+        pool.emplace_back(worker, id);
+    for (auto &t : pool)
+        t.join();
+    EXPECT_EQ(threads_count, finished.load());
+
+    alloc_t alloc;
+    long rest = 0;
+    for (auto &box : mailboxes)
+    {
+        for (auto p : box)
+        {
+            rest += *p;
+            alloc.destroy(p);
+            alloc.deallocate(p, 1);
+        }
+        box.clear();
+    }
+    long expected = 0;
+    for (int id = 0; id < threads_count; ++id)
+        for (int round = 0; round < rounds; ++round)
+            expected += batch * static_cast<long>(id * rounds + round);
+    EXPECT_EQ(expected, checksum.load() + rest);
+    EXPECT_EQ(alloc.max_size(), alloc.get_limit());
+    EXPECT_NO_THROW(alloc.set_limit(1));
+    alloc.set_limit(0);
+
+    auto set_worker = [](int id) {
+        std::set<int, std::less<int>, slvr::allocator::superK<int, slvr::allocator::concurrent>> s;
+        for (int i = 0; i < 5000; ++i)
+        {
+            s.insert((i * 31 + id) % 20);
+            if (s.size() > 5)
+                s.erase(s.begin());
+        }
+    };
+    pool.clear();
+    for (int id = 0; id < threads_count; ++id)
+        pool.emplace_back(set_worker, id);
+    for (auto &t : pool)
+        t.join();
+}
+
+TEST(allocator, private_arena)
+{
+    using pair_alloc = slvr::allocator::superK<std::pair<const int, int>>;
+    using arena_map = std::map<int, int, std::less<int>, pair_alloc>;
+
+    static_assert(!std::allocator_traits<pair_alloc>::is_always_equal::value, "");
+    static_assert(std::allocator_traits<pair_alloc>::propagate_on_container_move_assignment::value, "");
+    static_assert(std::allocator_traits<pair_alloc>::propagate_on_container_swap::value, "");
+    static_assert(std::allocator_traits<
+                      slvr::allocator::superK<int, slvr::allocator::concurrent>>::is_always_equal::value,
+                  "");
+
+    slvr::allocator::membuf local_arena;
+    pair_alloc local_alloc(local_arena);
+    EXPECT_TRUE(pair_alloc() == pair_alloc());
+    EXPECT_FALSE(local_alloc == pair_alloc());
+    EXPECT_TRUE(local_alloc == slvr::allocator::superK<long>(local_alloc));
+
+    auto owned = std::make_shared<slvr::allocator::membuf>();
+    std::weak_ptr<slvr::allocator::membuf> watch = owned;
+    {
+        arena_map m1(pair_alloc(std::move(owned)));
+        arena_map m2(local_alloc);
+        for (int i = 0; i < 5; ++i)
+        {
+            m1[i] = i;
+            m2[i] = -i;
+        }
+        m2[5] = -5;
+        EXPECT_FALSE(m1.get_allocator() == m2.get_allocator());
+
+        arena_map m3(pair_alloc::make_private());
+        m3 = std::move(m1);
+        EXPECT_EQ(5u, m3.size());
+        EXPECT_FALSE(watch.expired());
+        m3.swap(m2);
+        EXPECT_EQ(6u, m3.size());
+        EXPECT_EQ(-5, m3[5]);
+        EXPECT_TRUE(m3.get_allocator() == local_alloc);
+        EXPECT_EQ(4, m2[4]);
+    }
+    EXPECT_TRUE(watch.expired());
+
+    slvr::allocator::superK<long> limited(local_arena);
+    slvr::allocator::superK<long> shared;
+    limited.set_limit(2);
+    auto pl = limited.allocate(2);
+    EXPECT_THROW(limited.allocate(1), std::bad_alloc);
+    auto ps = shared.allocate(3);
+    EXPECT_EQ(std::numeric_limits<size_t>::max() / sizeof(long), shared.get_limit());
+    shared.deallocate(ps, 3);
+    limited.deallocate(pl, 2);
+    limited.set_limit(0);
+}
+
+TEST(allocator, pmr_resource)
+{
+    using slvr::allocator::membuf_resource;
+    using slvr::allocator::resource_mode;
+
+    slvr::allocator::membuf shared_arena;
+    membuf_resource pooled(shared_arena);
+    slvr::allocator::superK<long> shared_alloc(shared_arena);
+
+    {
+        std::pmr::vector<int> v(&pooled);
+        std::pmr::map<int, long> m(&pooled);
+        slvr::container::massive<int, std::pmr::polymorphic_allocator<int>> arr(&pooled);
+        std::vector<long, slvr::allocator::superK<long>> sv(shared_alloc);
+        for (int i = 0; i < 1000; ++i)
+        {
+            v.push_back(i);
+            m[i % 50] += i;
+            arr.push_back(-i);
+            sv.push_back(i);
+            if (m.size() > 40)
+                m.erase(m.begin());
+        }
+        long sum = 0;
+        for (auto el : arr)
+            sum += el;
+        EXPECT_EQ(-499500, sum);
+        EXPECT_EQ(999, v.back());
+        EXPECT_EQ(999, sv.back());
+        EXPECT_TRUE(arr.get_allocator().resource()->is_equal(pooled));
+    }
+
+    membuf_resource other(shared_arena);
+    membuf_resource monotonic(resource_mode::monotonic, slvr::allocator::arena_options{256, 2});
+    EXPECT_TRUE(pooled.is_equal(other));
+    EXPECT_FALSE(pooled.is_equal(monotonic));
+    EXPECT_FALSE(pooled.is_equal(*std::pmr::new_delete_resource()));
+
+    {
+        std::pmr::vector<long> v(&monotonic);
+        for (long i = 0; i < 10000; ++i)
+            v.push_back(i);
+        EXPECT_EQ(9999, v[9999]);
+    }
+    EXPECT_LT(1u, monotonic.arena().chunks());
+    EXPECT_EQ(resource_mode::monotonic, monotonic.mode());
+}
+
+TEST(allocator, alignment)
+{
+    struct alignas(32) wide
+    {
+        double lanes[4];
+    };
+    auto is_aligned = [](const void *p, size_t alignment) {
+        return reinterpret_cast<std::uintptr_t>(p) % alignment == 0;
+    };
+
+    slvr::allocator::membuf arena;
+    slvr::allocator::superK<char> alloc_c(arena);
+    slvr::allocator::superK<long double> alloc_ld(arena);
+    slvr::allocator::superK<wide> alloc_w(arena);
+
+    auto pc = alloc_c.allocate(3);
+    auto pld = alloc_ld.allocate(2);
+    auto pc2 = alloc_c.allocate(1);
+    auto pw = alloc_w.allocate(3);
+    EXPECT_TRUE(is_aligned(pld, alignof(long double)));
+    EXPECT_TRUE(is_aligned(pw, 32));
+    alloc_w.construct(pw + 2, wide{{1.0, 2.0, 3.0, 4.0}});
+    EXPECT_EQ(4.0, pw[2].lanes[3]);
+
+    slvr::allocator::superK<int> alloc_i(arena);
+    EXPECT_EQ(alignof(int), alloc_i.get_alignment());
+    alloc_i.set_alignment(slvr::allocator::cache_line_alignment);
+    EXPECT_THROW(alloc_i.set_alignment(48), std::domain_error);
+    {
+        slvr::container::massive<int, slvr::allocator::superK<int>> arr(alloc_i);
+        for (int i = 0; i < 100; ++i)
+        {
+            arr.push_back(i);
+            EXPECT_TRUE(is_aligned(&arr[0], slvr::allocator::cache_line_alignment));
+        }
+        EXPECT_THROW(alloc_i.set_alignment(slvr::allocator::simd_alignment), std::domain_error);
+    }
+    EXPECT_NO_THROW(alloc_i.set_alignment(slvr::allocator::simd_alignment));
+    auto pi = alloc_i.allocate(5);
+    EXPECT_TRUE(is_aligned(pi, slvr::allocator::simd_alignment));
+    alloc_i.deallocate(pi, 5);
+
+    slvr::allocator::superK<wide, slvr::allocator::concurrent> alloc_cw;
+    auto pcw = alloc_cw.allocate(2);
+    EXPECT_TRUE(is_aligned(pcw, 32));
+    alloc_cw.deallocate(pcw, 2);
+
+    slvr::allocator::membuf_resource resource(arena);
+    void *raw = resource.allocate(40, 64);
+    EXPECT_TRUE(is_aligned(raw, 64));
+    resource.deallocate(raw, 40, 64);
+
+    alloc_w.deallocate(pw, 3);
+    alloc_c.deallocate(pc2, 1);
+    alloc_ld.deallocate(pld, 2);
+    alloc_c.deallocate(pc, 3);
+}
+
+TEST(allocator, mmap_backing)
+{
+    slvr::allocator::arena_options opts;
+    opts.initial_size = 1 << 16;
+    opts.backing = slvr::allocator::backing_store::mmap;
+    opts.huge_pages = true;
+    opts.prefault = true;
+    slvr::allocator::membuf arena(opts);
+    EXPECT_LE(static_cast<size_t>(1 << 16), arena.reserved());
+
+    using mapped_alloc = slvr::allocator::superK<std::pair<const int, long>>;
+    {
+        std::map<int, long, std::less<int>, mapped_alloc> m{mapped_alloc(arena)};
+        for (int i = 0; i < 20000; ++i)
+            m[i] = 2L * i;
+        EXPECT_EQ(39998, m[19999]);
+    }
+    EXPECT_EQ(1u, arena.chunks());
+
+    auto p = reinterpret_cast<long *>(arena.place(100, sizeof(long)));
+    p[99] = 7;
+    EXPECT_EQ(7, p[99]);
+    arena.clean(reinterpret_cast<char *>(p), 100, sizeof(long));
+
+#if defined(SLVR_HAS_MMAP) && defined(MADV_DONTNEED)
+    // При сбросе блока страницы в пределах retain_bytes остаются, дальше - отдаются
+    slvr::allocator::arena_options trim_opts;
+    trim_opts.initial_size = 4 << 20;
+    trim_opts.backing = slvr::allocator::backing_store::mmap;
+    trim_opts.retain_bytes = 256 << 10;
+    slvr::allocator::membuf trimmed(trim_opts);
+    const size_t page = static_cast<size_t>(::sysconf(_SC_PAGESIZE));
+    auto resident = [&](const char *q) {
+        unsigned char vec = 0;
+        auto base = reinterpret_cast<std::uintptr_t>(q) & ~(page - 1);
+        EXPECT_EQ(0, ::mincore(reinterpret_cast<void *>(base), page, &vec));
+        return (vec & 1) != 0;
+    };
+    char *small = trimmed.place(64 << 10, 1);
+    std::fill_n(small, 64 << 10, 'x');
+    trimmed.clean(small, 64 << 10, 1);
+    EXPECT_TRUE(resident(small + (60 << 10)));
+    char *large = trimmed.place(2 << 20, 1);
+    std::fill_n(large, 2 << 20, 'x');
+    trimmed.clean(large, 2 << 20, 1);
+    EXPECT_TRUE(resident(large + (200 << 10)));
+    EXPECT_FALSE(resident(large + (1 << 20)));
+#endif
+}
+
+TEST(allocator, stats)
+{
+    slvr::allocator::membuf arena;
+    slvr::allocator::superK<long> alloc_l(arena);
+    slvr::allocator::superK<int> alloc_i(arena);
+
+    auto p1 = alloc_l.allocate(4);
+    auto p2 = alloc_l.allocate(2);
+    auto p3 = alloc_i.allocate(10);
+    alloc_l.deallocate(p1, 4);
+
+    auto ls = alloc_l.stats();
+    EXPECT_EQ(2u, ls.live_objects);
+    EXPECT_EQ(2 * sizeof(long), ls.live_bytes);
+    EXPECT_EQ(6u, ls.peak_objects);
+    EXPECT_EQ(2u, ls.allocations);
+    EXPECT_EQ(0u, ls.failures);
+    EXPECT_EQ(alignof(long), ls.alignment);
+
+    alloc_i.set_limit(10);
+    EXPECT_THROW(alloc_i.allocate(1), std::bad_alloc);
+    auto is = alloc_i.stats();
+    EXPECT_EQ(1u, is.failures);
+    EXPECT_EQ(10u, is.limit);
+    EXPECT_EQ(10u, is.live_objects);
+
+    auto as = arena.stats();
+    EXPECT_EQ(2u, as.live_blocks);
+    EXPECT_EQ(3u, as.allocations);
+    EXPECT_EQ(1u, as.deallocations);
+    EXPECT_EQ(4 * sizeof(long), as.free_list_bytes);
+    EXPECT_EQ(2 * sizeof(long) + 10 * sizeof(int), as.live_bytes);
+    EXPECT_EQ(as.live_bytes + 4 * sizeof(long), as.peak_bytes);
+    EXPECT_LE(1024u, as.reserved);
+    size_t histogram_total = 0;
+    for (auto &bucket : as.histogram)
+        histogram_total += bucket.second;
+    EXPECT_EQ(3u, histogram_total);
+
+    alloc_i.deallocate(p3, 10);
+    alloc_l.deallocate(p2, 2);
+    as = arena.stats();
+    EXPECT_EQ(0u, as.live_blocks);
+    EXPECT_EQ(0u, as.live_bytes);
+    EXPECT_EQ(0u, as.free_list_bytes);
+}
+
+TEST(allocator, arena_scope)
+{
+    slvr::allocator::membuf arena;
+    slvr::allocator::superK<int> alloc(arena);
+    alloc.set_limit(1600);
+    int *outer = alloc.allocate(4);
+    int *outer_freed = alloc.allocate(8);
+    size_t reserved = arena.stats().reserved;
+    // Без снятия учета по типам лимит кончился бы на втором круге
+    for (int round = 0; round < 3; ++round)
+    {
+        slvr::allocator::arena_scope scope(alloc);
+        // Контейнеры не разрушаются: память области освобождается разом
+        using int_vector = std::vector<int, slvr::allocator::superK<int>>;
+        using int_map = std::map<int, int, std::less<int>, slvr::allocator::superK<std::pair<const int, int>>>;
+        auto &v = *scope.create_unmanaged<int_vector>(alloc);
+        for (int i = 0; i < 1000; ++i)
+            v.push_back(i);
+        auto &m = *scope.create_unmanaged<int_map>(alloc);
+        for (int i = 0; i < 100; ++i)
+            m[i] = i;
+        if (round == 0)
+            alloc.deallocate(outer_freed, 8);
+        EXPECT_LT(reserved, arena.stats().reserved);
+        EXPECT_EQ(v.capacity() + 4, alloc.stats().live_objects);
+    }
+    auto as = arena.stats();
+    EXPECT_EQ(1u, as.live_blocks);
+    EXPECT_EQ(4u, alloc.stats().live_objects);
+    // Кроме первого куска остается только запасной кусок для следующей области
+    EXPECT_EQ(1u, as.chunks);
+    EXPECT_LT(reserved, as.reserved);
+    // Блок, освобожденный в области, вернулся в списки внешнего уровня
+    EXPECT_EQ(outer_freed, alloc.allocate(8));
+
+    static int destroyed = 0;
+    struct tracked
+    {
+        int value;
+        explicit tracked(int v) : value(v) {}
+        ~tracked() { destroyed += value; }
+    };
+    {
+        slvr::allocator::arena_scope outer_scope(arena);
+        outer_scope.create<tracked>(1);
+        slvr::allocator::arena_scope inner(arena);
+        EXPECT_EQ(2, inner.create<tracked>(2)->value);
+        EXPECT_EQ(7, *inner.create<int>(7));
+        EXPECT_EQ(3u, inner.live_blocks());
+        outer_scope.release();
+        EXPECT_FALSE(inner.active());
+        EXPECT_EQ(3, destroyed);
+        EXPECT_THROW(inner.create<int>(1), std::logic_error);
+    }
+    EXPECT_EQ(3, destroyed);
+    EXPECT_EQ(2u, arena.stats().live_blocks);
+
+    // Блок снаружи области не растягивается за ее отметку
+    slvr::allocator::membuf tail;
+    slvr::allocator::superK<int> tail_alloc(tail);
+    int *last = tail_alloc.allocate(4);
+    {
+        slvr::allocator::arena_scope scope(tail);
+        EXPECT_FALSE(tail_alloc.try_expand(last, 4, 8));
+        int *in_scope = tail_alloc.allocate(4);
+        EXPECT_TRUE(tail_alloc.try_expand(in_scope, 4, 16));
+    }
+    EXPECT_EQ(4u, tail_alloc.stats().live_objects);
+    EXPECT_TRUE(tail_alloc.try_expand(last, 4, 8));
+    tail_alloc.deallocate(last, 8);
+    alloc.deallocate(outer_freed, 8);
+    alloc.deallocate(outer, 4);
+    EXPECT_EQ(0u, arena.stats().live_blocks);
+}
+
+TEST(allocator, trace)
+{
+    using slvr::trace::kind;
+    auto &rec = slvr::trace::recorder::global();
+    rec.clear();
+    slvr::allocator::membuf arena;
+    slvr::allocator::superK<long> alloc(arena);
+    alloc.set_limit(6);
+    rec.enable();
+    long *p = alloc.allocate(4);
+    alloc.construct(p, 7L);
+    alloc.destroy(p);
+    EXPECT_THROW(alloc.allocate(4), std::bad_alloc);
+    alloc.deallocate(p, 4);
+    slvr::container::massive<int> arr;
+    arr.reserve(64);
+    std::vector<int> bulk(100, 1);
+    arr.append(bulk.begin(), bulk.end());
+    std::thread([&] { alloc.deallocate(alloc.allocate(1), 1); }).join();
+    rec.disable();
+    alloc.deallocate(alloc.allocate(1), 1);
+
+    auto events = rec.events();
+    std::vector<kind> kinds;
+    for (auto &e : events)
+        kinds.push_back(e.what);
+    std::vector<kind> expected{kind::allocate, kind::construct, kind::destroy, kind::failure, kind::deallocate,
+                               kind::adjust_capacity, kind::adjust_capacity, kind::allocate, kind::deallocate};
+    EXPECT_EQ(expected, kinds);
+    ASSERT_EQ(expected.size(), events.size());
+    EXPECT_EQ(p, events[0].address);
+    EXPECT_EQ(4 * sizeof(long), events[0].bytes);
+    EXPECT_TRUE(*events[0].type == typeid(long));
+    EXPECT_EQ(64u, events[5].count);
+    EXPECT_EQ(64u, events[6].previous);
+    EXPECT_LE(100u, events[6].count);
+    EXPECT_NE(events[0].thread, events[7].thread);
+    for (size_t i = 1; i < events.size(); ++i)
+        EXPECT_LE(events[i - 1].time_ns, events[i].time_ns);
+
+    std::ostringstream json;
+    rec.write_chrome_trace(json);
+    std::string text = json.str();
+    EXPECT_EQ(0u, text.find("{\"displayTimeUnit\":\"ns\",\"traceEvents\":["));
+    EXPECT_NE(std::string::npos, text.find("\"name\":\"failure\""));
+    EXPECT_NE(std::string::npos, text.find("\"type\":\"long\""));
+    EXPECT_NE(std::string::npos, text.find("\"name\":\"adjust_capacity\",\"cat\":\"massive\""));
+    EXPECT_NE(std::string::npos, text.find("\"name\":\"live bytes\",\"ph\":\"C\""));
+    EXPECT_EQ(std::count(text.begin(), text.end(), '{'), std::count(text.begin(), text.end(), '}'));
+    EXPECT_EQ(0u, rec.dropped());
+    rec.clear();
+    EXPECT_TRUE(rec.events().empty());
+    EXPECT_THROW(rec.enable(1000), std::invalid_argument);
+
+    // Переполненное кольцо хранит последние события
+    slvr::trace::ring r(4, 1);
+    for (std::uint64_t i = 0; i < 6; ++i)
+        r.push(slvr::trace::event{i, &typeid(int), nullptr, i, 0, 0, 0, kind::allocate, alignof(int)});
+    std::vector<slvr::trace::event> last;
+    r.copy_to(last);
+    ASSERT_EQ(4u, last.size());
+    EXPECT_EQ(2u, last.front().count);
+    EXPECT_EQ(5u, last.back().count);
+}
+
+TEST(allocator, replay)
+{
+    namespace replay = slvr::replay;
+    auto &rec = slvr::trace::recorder::global();
+    rec.clear();
+    auto early = slvr::allocator::superK<long>::make_private();
+    long *before = early.allocate(2);
+    rec.enable(slvr::trace::recorder::default_capacity, slvr::trace::allocation_kinds);
+    early.deallocate(before, 2);
+    {
+        auto wide = slvr::allocator::superK<double>::make_private();
+        wide.set_alignment(slvr::allocator::cache_line_alignment);
+        wide.deallocate(wide.allocate(3), 3);
+        auto alloc = slvr::allocator::superK<int>::make_private();
+        std::map<int, int, std::less<int>, slvr::allocator::superK<std::pair<const int, int>>> m(alloc);
+        for (int i = 0; i < 200; ++i)
+            m[i] = i;
+        for (int i = 0; i < 200; i += 2)
+            m.erase(i);
+        slvr::container::massive<int, slvr::allocator::superK<int>> arr(alloc);
+        for (int i = 0; i < 500; ++i)
+            arr.push_back(i);
+    }
+    rec.disable();
+    for (auto &e : rec.events())
+        EXPECT_NE(0u, slvr::trace::allocation_kinds & slvr::trace::bit(e.what));
+    replay::workload w = replay::from_events(rec.events());
+    rec.clear();
+    EXPECT_EQ(1u, w.unmatched);
+    ASSERT_FALSE(w.ops.empty());
+    EXPECT_EQ(slvr::allocator::cache_line_alignment, w.ops[0].alignment);
+    EXPECT_EQ(3 * sizeof(double), w.ops[0].bytes);
+
+    size_t allocs = 0, frees = 0, resizes = 0;
+    for (auto &op : w.ops)
+        (op.kind == replay::op_kind::allocate ? allocs : op.kind == replay::op_kind::deallocate ? frees : resizes)++;
+    EXPECT_EQ(allocs, w.blocks);
+    EXPECT_EQ(allocs, frees);
+    EXPECT_LE(200u, allocs);
+    EXPECT_LT(0u, resizes);
+
+    std::string path = "replay_test.trc";
+    replay::save(w, path);
+    replay::workload loaded = replay::load(path);
+    ASSERT_EQ(w.ops.size(), loaded.ops.size());
+    EXPECT_EQ(w.blocks, loaded.blocks);
+    for (size_t i = 0; i < w.ops.size(); ++i)
+    {
+        EXPECT_EQ(w.ops[i].kind, loaded.ops[i].kind);
+        EXPECT_EQ(w.ops[i].id, loaded.ops[i].id);
+        EXPECT_EQ(w.ops[i].bytes, loaded.ops[i].bytes);
+        if (w.ops[i].kind == replay::op_kind::allocate)
+        {
+            EXPECT_EQ(w.ops[i].alignment, loaded.ops[i].alignment);
+        }
+    }
+    {
+        std::ifstream in(path, std::ios::binary | std::ios::ate);
+        EXPECT_GT(w.ops.size() * 4, static_cast<size_t>(in.tellg()));
+    }
+    {
+        std::fstream f(path, std::ios::in | std::ios::out | std::ios::binary);
+        f.seekp(0);
+        f.put('X');
+    }
+    EXPECT_THROW(replay::load(path), std::runtime_error);
+    std::remove(path.c_str());
+
+    auto results = replay::run_all(w, 2);
+    ASSERT_EQ(4u, results.size());
+    for (auto &r : results)
+    {
+        EXPECT_EQ(w.ops.size(), r.operations);
+        EXPECT_EQ(results[0].peak_live_bytes, r.peak_live_bytes);
+        EXPECT_LE(r.peak_live_bytes, r.peak_footprint);
+        EXPECT_LE(0.0, r.fragmentation);
+        EXPECT_GT(1.0, r.fragmentation);
+        EXPECT_LT(0.0, r.ops_per_second);
+    }
+    std::ostringstream table;
+    replay::print(table, results);
+    EXPECT_NE(std::string::npos, table.str().find("membuf free lists"));
+}
+
+TEST(container, in_place_growth)
+{
+    using arena_alloc = slvr::allocator::superK<int>;
+    static_assert(slvr::container::has_try_expand<arena_alloc>::value, "");
+    static_assert(!slvr::container::has_try_expand<std::allocator<int>>::value, "");
+
+    auto alloc = arena_alloc::make_private(slvr::allocator::arena_options{1 << 16, 2});
+    slvr::container::massive<int, arena_alloc> arr(alloc);
+    arr.push_back(0);
+    int *data = &arr[0];
+    for (int i = 1; i < 1000; ++i)
+        arr.push_back(i);
+    EXPECT_EQ(data, &arr[0]);
+    EXPECT_EQ(999, arr[999]);
+    EXPECT_EQ(1u, alloc.stats().allocations);
+    EXPECT_EQ(arr.capacity(), alloc.stats().live_objects);
+
+    arr.reserve(5000);
+    EXPECT_EQ(data, &arr[0]);
+    EXPECT_EQ(5000u, arr.capacity());
+
+    auto blocker = alloc.allocate(1);
+    arr.reserve(6000);
+    EXPECT_NE(data, &arr[0]);
+    EXPECT_EQ(500, arr[500]);
+    alloc.deallocate(blocker, 1);
+
+    int *p = alloc.allocate(4);
+    EXPECT_TRUE(alloc.try_expand(p, 4, 8));
+    EXPECT_FALSE(alloc.try_expand(p, 8, std::numeric_limits<size_t>::max()));
+    alloc.set_limit(alloc.stats().live_objects);
+    EXPECT_FALSE(alloc.try_expand(p, 8, 9));
+    alloc.set_limit(0);
+    alloc.deallocate(p, 8);
+
+    slvr::allocator::superK<long, slvr::allocator::concurrent> calloc;
+    long *q = calloc.allocate(2);
+    EXPECT_TRUE(calloc.try_expand(q, 2, 20));
+    q[19] = 19;
+    calloc.deallocate(q, 20);
+}
+
+TEST(container, random_access)
+{
+    using arr_t = slvr::container::massive<int, slvr::allocator::superK<int>>;
+    static_assert(std::is_same<std::iterator_traits<arr_t::iterator>::iterator_category,
+                               std::random_access_iterator_tag>::value,
+                  "");
+    static_assert(std::is_same<decltype(*std::declval<const arr_t &>().begin()), const int &>::value, "");
+
+    arr_t arr(slvr::allocator::superK<int>::make_private());
+    for (int i = 0; i < 50; ++i)
+        arr.push_back((i * 37) % 50);
+    std::sort(arr.begin(), arr.end());
+    EXPECT_TRUE(std::is_sorted(arr.cbegin(), arr.cend()));
+    EXPECT_EQ(50, arr.end() - arr.begin());
+
+    const arr_t &carr = arr;
+    auto found = std::lower_bound(carr.begin(), carr.end(), 17);
+    EXPECT_EQ(17, *found);
+    EXPECT_EQ(17, found - carr.begin());
+    EXPECT_EQ(20, found[3]);
+    EXPECT_TRUE(found < carr.end() && carr.begin() <= found);
+    arr_t::const_iterator from_mutable = arr.begin() + 5;
+    EXPECT_EQ(5, *from_mutable);
+    EXPECT_TRUE(from_mutable == arr.begin() + 5);
+
+    EXPECT_EQ(arr.data(), &arr[0]);
+    EXPECT_EQ(49, carr[49]);
+    EXPECT_EQ(49, *arr.rbegin());
+    EXPECT_EQ(0, *(carr.crend() - 1));
+    std::string reversed;
+    for (auto it = carr.rbegin(); it != carr.rbegin() + 3; ++it)
+        reversed += std::to_string(*it);
+    EXPECT_STRCASEEQ("494847", reversed.c_str());
+
+    long long total = std::accumulate(carr.begin(), carr.end(), 0LL);
+    EXPECT_EQ(1225, total);
+}
+
+template <typename T>
+void check_simd_kernels()
+{
+    namespace simd = slvr::container::simd;
+    slvr::container::massive<T> arr;
+    std::mt19937_64 gen(42);
+    for (int i = 0; i < 1237; ++i)
+        arr.push_back(static_cast<T>(gen()));
+    arr.push_back(std::numeric_limits<T>::min());
+    arr.push_back(std::numeric_limits<T>::max());
+    const T probe = arr[700];
+    const T missing_lo = arr[3] < arr[4] ? arr[3] : arr[4];
+    const T missing_hi = arr[3] < arr[4] ? arr[4] : arr[3];
+
+    unsigned long long expected_sum = 0;
+    for (auto el : arr)
+        expected_sum += static_cast<unsigned long long>(el);
+
+    const simd::isa saved = simd::active_isa();
+    for (auto mode : {simd::isa::scalar, simd::isa::sse42, simd::isa::avx2})
+    {
+        if (mode > simd::detect_isa())
+            continue;
+        simd::active_isa() = mode;
+        EXPECT_EQ(static_cast<simd::sum_type<T>>(expected_sum), arr.sum());
+        EXPECT_EQ(std::numeric_limits<T>::min(), arr.min());
+        EXPECT_EQ(std::numeric_limits<T>::max(), arr.max());
+        EXPECT_EQ(static_cast<size_t>(std::count(arr.begin(), arr.end(), probe)), arr.count(probe));
+        EXPECT_TRUE(std::find(arr.begin(), arr.end(), probe) == arr.find(probe));
+        EXPECT_TRUE(arr.contains(probe));
+
+        auto hist = arr.histogram(missing_lo, missing_hi, 7);
+        size_t in_range = static_cast<size_t>(std::count_if(arr.begin(), arr.end(), [&](T el) {
+            return !(el < missing_lo) && !(missing_hi < el);
+        }));
+        EXPECT_EQ(in_range, std::accumulate(hist.begin(), hist.end(), size_t{0}));
+    }
+    simd::active_isa() = saved;
+}
+
+TEST(container, simd_kernels)
+{
+    check_simd_kernels<signed char>();
+    check_simd_kernels<unsigned char>();
+    check_simd_kernels<short>();
+    check_simd_kernels<int>();
+    check_simd_kernels<unsigned>();
+    check_simd_kernels<long long>();
+    check_simd_kernels<unsigned long long>();
+
+    slvr::container::massive<int> arr;
+    EXPECT_EQ(0, arr.sum());
+    EXPECT_THROW(arr.min(), std::range_error);
+    EXPECT_TRUE(arr.find(5) == arr.end());
+    for (int i = 0; i < 100; ++i)
+        arr.push_back(i % 10);
+    EXPECT_EQ(450, arr.sum());
+    EXPECT_EQ(10u, arr.count(3));
+    EXPECT_EQ(3, arr.find(3) - arr.begin());
+    EXPECT_FALSE(arr.contains(10));
+    std::vector<size_t> hist = arr.histogram(0, 9, 5);
+    EXPECT_EQ(std::vector<size_t>(5, 20), hist);
+    EXPECT_EQ(std::vector<size_t>(1, 40), arr.histogram(2, 5, 1));
+
+    // Диапазон на весь 64-битный тип
+    slvr::container::massive<unsigned long long> wide;
+    wide.push_back(0);
+    wide.push_back(std::numeric_limits<unsigned long long>::max());
+    EXPECT_EQ(std::vector<size_t>(1, 2), wide.histogram(0, std::numeric_limits<unsigned long long>::max(), 1));
+    EXPECT_EQ((std::vector<size_t>{1, 1}), wide.histogram(0, std::numeric_limits<unsigned long long>::max(), 2));
+    slvr::container::massive<int64_t> signed_wide;
+    signed_wide.push_back(std::numeric_limits<int64_t>::min());
+    signed_wide.push_back(0);
+    signed_wide.push_back(std::numeric_limits<int64_t>::max());
+    EXPECT_EQ(std::vector<size_t>(1, 3),
+              signed_wide.histogram(std::numeric_limits<int64_t>::min(), std::numeric_limits<int64_t>::max(), 1));
+    EXPECT_EQ((std::vector<size_t>{1, 2}),
+              signed_wide.histogram(std::numeric_limits<int64_t>::min(), std::numeric_limits<int64_t>::max(), 2));
+}
+
+TEST(container, bulk_append)
+{
+    using arena_alloc = slvr::allocator::superK<int>;
+    auto alloc = arena_alloc::make_private();
+    slvr::container::massive<int, arena_alloc> arr(alloc);
+
+    std::vector<int> ids(100000);
+    std::iota(ids.begin(), ids.end(), 0);
+    arr.append(ids.data(), ids.data() + ids.size());
+    EXPECT_EQ(ids.size(), arr.size());
+    EXPECT_EQ(99999, arr[99999]);
+    EXPECT_EQ(2u, alloc.stats().allocations);
+
+    arr.append(arr.cbegin(), arr.cbegin() + 3);
+    arr.append(arr.begin(), arr.end());
+    EXPECT_EQ(2 * (ids.size() + 3), arr.size());
+    EXPECT_EQ(2, arr[ids.size() + 2]);
+    EXPECT_EQ(99999, arr[2 * ids.size() + 2]);
+
+    std::set<int> ordered{7, 3, 5};
+    arr.resize(0);
+    arr.append(ordered.begin(), ordered.end());
+    arr.append(arr.rbegin(), arr.rend());
+    std::string result;
+    for (auto el : arr)
+        result += std::to_string(el);
+    EXPECT_STRCASEEQ("357753", result.c_str());
+
+    std::istringstream input("1 2 3");
+    arr.append(std::istream_iterator<int>(input), std::istream_iterator<int>());
+    EXPECT_EQ(9u, arr.size());
+    EXPECT_EQ(3, arr[8]);
+
+    arr.append_n(-1, 1000);
+    EXPECT_EQ(1009u, arr.size());
+    EXPECT_EQ(1000u, arr.count(-1));
+    slvr::container::massive<signed char> bytes;
+    bytes.append_n(static_cast<signed char>(-3), 33);
+    EXPECT_EQ(-99, bytes.sum());
+
+    int &added = arr.emplace_back(42);
+    EXPECT_EQ(42, added);
+    arr.push_back(std::move(added));
+    for (int i = 0; i < 20; ++i)
+        arr.push_back(arr[0]);
+    EXPECT_EQ(42, arr[1010]);
+    EXPECT_EQ(3, arr[1030]);
+}
+
+TEST(container, inline_storage)
+{
+    using arena_alloc = slvr::allocator::superK<int>;
+    using small_t = slvr::container::massive<int, arena_alloc, 16>;
+    static_assert(sizeof(small_t) >= 16 * sizeof(int), "");
+    static_assert(sizeof(slvr::container::massive<int>) <= 4 * sizeof(int *), "");
+
+    auto alloc = arena_alloc::make_private();
+    {
+        small_t arr(alloc);
+        EXPECT_EQ(16u, arr.capacity());
+        for (int i = 0; i < 16; ++i)
+            arr.push_back(i);
+        EXPECT_EQ(0u, alloc.stats().allocations);
+        EXPECT_EQ(120, arr.sum());
+
+        small_t copy(arr);
+        small_t moved(std::move(copy));
+        EXPECT_EQ(0u, alloc.stats().allocations);
+        EXPECT_EQ(0u, copy.size());
+        EXPECT_EQ(15, moved[15]);
+
+        arr.push_back(16);
+        EXPECT_EQ(1u, alloc.stats().allocations);
+        EXPECT_EQ(48u, arr.capacity());
+        EXPECT_EQ(16, arr[16]);
+
+        int *heap = arr.data();
+        small_t stolen(std::move(arr));
+        EXPECT_EQ(heap, stolen.data());
+        EXPECT_EQ(16u, arr.capacity());
+        arr.push_back(7);
+        EXPECT_EQ(7, arr[0]);
+
+        moved = stolen;
+        EXPECT_EQ(17u, moved.size());
+        stolen.resize(5);
+        stolen.resize(0);
+        EXPECT_EQ(16u, stolen.capacity());
+        EXPECT_EQ(moved.capacity(), alloc.stats().live_objects);
+    }
+    EXPECT_EQ(0u, alloc.stats().live_objects);
+
+    slvr::container::massive<long> plain;
+    plain.push_back(1);
+    slvr::container::massive<long> taken(std::move(plain));
+    plain.push_back(2);
+    plain = std::move(taken);
+    EXPECT_EQ(1, plain[0]);
+    EXPECT_EQ(0u, taken.size());
+}
+
+namespace
+{
+    /// Элемент с подсчетом живых объектов; копия бросает, когда countdown доходит до нуля
+    struct tracked
+    {
+        static int live;
+        static int countdown;
+        int value;
+
+        explicit tracked(int v) : value(v) { ++live; }
+        tracked(const tracked &other) : value(other.value)
+        {
+            if (countdown > 0 && --countdown == 0)
+                throw std::runtime_error("copy failed");
+            ++live;
+        }
+        tracked(tracked &&other) noexcept(false) : value(other.value) { ++live; }
+        ~tracked() { --live; }
+    };
+    int tracked::live = 0;
+    int tracked::countdown = 0;
+} // namespace
+
+TEST(container, non_integral)
+{
+    struct point
+    {
+        int x;
+        double y;
+    };
+    using point_alloc = slvr::allocator::superK<point>;
+    auto alloc = point_alloc::make_private();
+    {
+        slvr::container::massive<point, point_alloc, 16> points(alloc);
+        for (int i = 0; i < 100; ++i)
+            points.push_back(point{i, i * 0.5});
+        points.append(points.begin(), points.begin() + 10);
+        EXPECT_EQ(110u, points.size());
+        EXPECT_EQ(99, points[99].x);
+        EXPECT_EQ(4.5, points[109].y);
+        points.resize(3);
+        EXPECT_EQ(16u, points.capacity());
+        EXPECT_EQ(2, points[2].x);
+        slvr::container::massive<point, point_alloc, 16> moved(std::move(points));
+        EXPECT_EQ(1.0, moved[2].y);
+        EXPECT_EQ(0u, points.size());
+    }
+    EXPECT_EQ(0u, alloc.stats().live_objects);
+
+    slvr::container::massive<std::unique_ptr<int>> owners;
+    for (int i = 0; i < 50; ++i)
+        owners.emplace_back(new int(i));
+    EXPECT_EQ(49, *owners[49]);
+    int *first = owners[0].get();
+    slvr::container::massive<std::unique_ptr<int>> taken(std::move(owners));
+    EXPECT_EQ(first, taken[0].get());
+    taken.resize(1);
+    EXPECT_EQ(0, *taken[0]);
+
+    // Разные pmr-ресурсы: перемещающее присваивание переносит элементы по одному
+    using pmr_owner = std::pmr::polymorphic_allocator<std::unique_ptr<int>>;
+    std::pmr::monotonic_buffer_resource first_pool, second_pool;
+    slvr::container::massive<std::unique_ptr<int>, pmr_owner> left{pmr_owner(&first_pool)};
+    slvr::container::massive<std::unique_ptr<int>, pmr_owner> right{pmr_owner(&second_pool)};
+    for (int i = 0; i < 20; ++i)
+        right.emplace_back(new int(i));
+    int *moved_ptr = right[19].get();
+    left = std::move(right);
+    EXPECT_EQ(20u, left.size());
+    EXPECT_EQ(moved_ptr, left[19].get());
+    EXPECT_EQ(0u, right.size());
+    EXPECT_TRUE(left.get_allocator().resource() == &first_pool);
+
+    slvr::container::massive<std::string, std::allocator<std::string>, 2> words;
+    words.push_back("inline");
+    words.push_back(std::string(64, 'x'));
+    auto moved_words = std::move(words);
+    moved_words.push_back("heap");
+    EXPECT_EQ("inline", moved_words[0]);
+    EXPECT_EQ(64u, moved_words[1].size());
+    EXPECT_EQ(0u, words.size());
+    moved_words = words;
+    EXPECT_EQ(0u, moved_words.size());
+
+    // Перемещение может бросить - при переносе элементы копируются, сбой не меняет массив
+    {
+        slvr::container::massive<tracked> arr;
+        for (int i = 0; i < 10; ++i)
+            arr.emplace_back(i);
+        size_t capacity = arr.capacity();
+        tracked::countdown = 5;
+        EXPECT_THROW(arr.reserve(capacity * 4), std::runtime_error);
+        EXPECT_EQ(capacity, arr.capacity());
+        EXPECT_EQ(10, tracked::live);
+        EXPECT_EQ(9, arr[9].value);
+        tracked::countdown = 3;
+        EXPECT_THROW(slvr::container::massive<tracked> copy(arr), std::runtime_error);
+        EXPECT_EQ(10, tracked::live);
+        tracked::countdown = 0;
+        arr.resize(2);
+        EXPECT_EQ(2, tracked::live);
+    }
+    EXPECT_EQ(0, tracked::live);
+}
+
+TEST(container, growth_policy)
+{
+    using namespace slvr::container;
+    EXPECT_EQ(30u, classic_growth::grow(10, 11, 1000));
+    EXPECT_EQ(15u, compact_growth::grow(10, 11, 1000));
+    EXPECT_EQ(4u, compact_growth::grow(0, 1, 1000));
+    EXPECT_EQ(6u, compact_growth::grow(4, 5, 1000));
+    EXPECT_EQ(100u, double_growth::grow(10, 100, 1000));
+    EXPECT_EQ(1000u, double_growth::grow(900, 901, 1000));
+    EXPECT_EQ(400u, classic_growth::shrink(400, 100));
+    EXPECT_EQ(300u, classic_growth::shrink(404, 100));
+    EXPECT_EQ(10u, classic_growth::shrink(1000, 0));
+    EXPECT_EQ(1000u, sticky_growth::shrink(1000, 0));
+
+    massive<int, std::allocator<int>, 0, compact_growth> arr;
+    EXPECT_EQ(4u, arr.capacity());
+    std::vector<size_t> capacities;
+    for (int i = 0; i < 30; ++i)
+    {
+        arr.push_back(i);
+        if (capacities.empty() || capacities.back() != arr.capacity())
+            capacities.push_back(arr.capacity());
+    }
+    EXPECT_EQ((std::vector<size_t>{4, 6, 9, 13, 19, 28, 42}), capacities);
+    arr.resize(14);
+    EXPECT_EQ(42u, arr.capacity());
+    arr.resize(13);
+    EXPECT_EQ(19u, arr.capacity());
+    EXPECT_EQ(12, arr[12]);
+
+    massive<int, std::allocator<int>, 0, sticky_growth> sticky;
+    sticky.append_n(1, 1000);
+    sticky.resize(0);
+    EXPECT_EQ(1000u, sticky.capacity());
+}
+
+TEST(container, parallel_algorithms)
+{
+    slvr::parallel::thread_pool pool(3);
+    EXPECT_EQ(4u, pool.concurrency());
+
+    slvr::container::massive<int64_t> arr;
+    std::mt19937_64 gen(7);
+    for (int i = 0; i < 200003; ++i)
+        arr.push_back(static_cast<int64_t>(gen() % 1000000) - 500000);
+    std::vector<int64_t> expected(arr.begin(), arr.end());
+
+    auto bounds = slvr::parallel::chunk_bounds(arr.data(), arr.size(), pool);
+    EXPECT_GT(bounds.size(), 2u);
+    for (size_t i = 1; i + 1 < bounds.size(); ++i)
+        EXPECT_EQ(0u, reinterpret_cast<std::uintptr_t>(arr.data() + bounds[i]) % slvr::parallel::cache_line);
+
+    arr.parallel_transform([](int64_t x) { return x * 3; }, pool);
+    for (auto &x : expected)
+        x *= 3;
+    EXPECT_TRUE(std::equal(expected.begin(), expected.end(), arr.begin()));
+
+    std::atomic<size_t> visited{0};
+    arr.parallel_for_each([&](int64_t &x) { ++x; visited.fetch_add(1, std::memory_order_relaxed); }, pool);
+    EXPECT_EQ(arr.size(), visited.load());
+    long long total = std::accumulate(expected.begin(), expected.end(), 0LL) + static_cast<long long>(arr.size());
+    EXPECT_EQ(total, arr.parallel_reduce(0LL, std::plus<long long>(), pool));
+    EXPECT_EQ(arr.max(), arr.parallel_reduce(std::numeric_limits<int64_t>::min(),
+                                             [](int64_t a, int64_t b) { return std::max(a, b); }, pool));
+
+    arr.parallel_sort(std::greater<int64_t>(), pool);
+    EXPECT_TRUE(std::is_sorted(arr.begin(), arr.end(), std::greater<int64_t>()));
+    arr.parallel_sort();
+    EXPECT_TRUE(std::is_sorted(arr.begin(), arr.end()));
+    EXPECT_EQ(total, arr.parallel_reduce(0LL, std::plus<long long>()));
+
+    std::atomic<int> inner{0};
+    pool.run(4, [&](size_t) { pool.run(8, [&](size_t) { ++inner; }); });
+    EXPECT_EQ(32, inner.load());
+    EXPECT_THROW(pool.run(16, [](size_t i) {
+        if (i == 11)
+            throw std::runtime_error("task failed");
+    }),
+                 std::runtime_error);
+}
+
+TEST(container, snapshot)
+{
+    using slvr::container::massive_view;
+    const std::string path = ::testing::TempDir() + "slvr_snapshot_test.bin";
+
+    slvr::container::massive<int64_t> arr;
+    for (int64_t i = 0; i < 100000; ++i)
+        arr.push_back(i * i - 7);
+    slvr::container::save(arr, path);
+
+    massive_view<int64_t> view(path);
+    EXPECT_EQ(arr.size(), view.size());
+    EXPECT_EQ(0u, reinterpret_cast<std::uintptr_t>(view.data()) % 64);
+    EXPECT_TRUE(std::equal(arr.begin(), arr.end(), view.begin()));
+    EXPECT_EQ(-7, view[0]);
+    EXPECT_THROW(view[view.size()], std::range_error);
+    EXPECT_TRUE(view.verify());
+
+    using arena_massive = slvr::container::massive<int64_t, slvr::allocator::superK<int64_t>>;
+    auto alloc = slvr::allocator::superK<int64_t>::make_private();
+    arena_massive copy = view.to_massive<arena_massive>(alloc);
+    copy.push_back(1);
+    EXPECT_EQ(arr.size() + 1, copy.size());
+    EXPECT_EQ(arr.sum() + 1, copy.sum());
+    EXPECT_EQ(copy.capacity(), alloc.stats().live_objects);
+
+    massive_view<int64_t> moved(std::move(view));
+    EXPECT_EQ(arr[99999], moved[99999]);
+    EXPECT_EQ(0u, view.size());
+    EXPECT_TRUE(view.empty());
+    EXPECT_EQ(nullptr, view.data());
+    EXPECT_TRUE(view.begin() == view.end());
+    EXPECT_THROW(view[0], std::range_error);
+    EXPECT_TRUE(view.verify());
+    EXPECT_EQ(0u, view.to_massive().size());
+    view = std::move(moved);
+    EXPECT_EQ(arr[0], view[0]);
+    EXPECT_EQ(0u, moved.size());
+
+    EXPECT_THROW(massive_view<uint64_t>{path}, std::runtime_error);
+    EXPECT_THROW(massive_view<int>{path}, std::runtime_error);
+    EXPECT_THROW(massive_view<int64_t>{path + ".missing"}, std::runtime_error);
+
+    {
+        std::fstream f(path, std::ios::binary | std::ios::in | std::ios::out);
+        f.seekp(sizeof(slvr::container::snapshot::header) + 8);
+        f.put('\x55');
+    }
+    EXPECT_FALSE(massive_view<int64_t>(path).verify());
+
+    slvr::container::massive<short> empty;
+    slvr::container::save(empty, path);
+    massive_view<short> empty_view(path);
+    EXPECT_TRUE(empty_view.empty());
+    EXPECT_TRUE(empty_view.verify());
+    std::remove(path.c_str());
+}
+
+TEST(container, packed_massive)
+{
+    using slvr::container::packed_massive;
+    namespace simd = slvr::container::simd;
+    std::mt19937_64 gen(11);
+
+    std::vector<int64_t> values;
+    for (int i = 0; i < 1000; ++i)
+        values.push_back(static_cast<int64_t>(gen() % 200) - 100);
+    int64_t stamp = 1700000000000;
+    for (int i = 0; i < 1000; ++i)
+        values.push_back(stamp += static_cast<int64_t>(gen() % 16));
+    values.insert(values.end(), 300, 42);
+    for (int i = 0; i < 300; ++i)
+        values.push_back(i % 2 ? std::numeric_limits<int64_t>::max() : std::numeric_limits<int64_t>::min());
+    for (int i = 0; i < 77; ++i)
+        values.push_back(static_cast<int64_t>(gen()));
+
+    packed_massive<int64_t> packed;
+    packed.append(values.begin(), values.end());
+    EXPECT_EQ(values.size(), packed.size());
+    EXPECT_EQ((values.size() + 127) / 128, packed.block_count());
+    EXPECT_TRUE(std::equal(values.begin(), values.end(), packed.begin()));
+    EXPECT_EQ(values[1500], packed[1500]);
+    EXPECT_EQ(values.back(), packed[values.size() - 1]);
+    EXPECT_THROW(packed[values.size()], std::range_error);
+    auto it = packed.begin();
+    auto lagging = it;
+    for (int i = 0; i < 300; ++i)
+        ++it;
+    EXPECT_EQ(values[300], *it);
+    EXPECT_EQ(values[0], *lagging);
+    EXPECT_EQ(values[300], *it);
+
+    EXPECT_EQ(8u, packed.block_width(0));
+    EXPECT_FALSE(packed.block_is_delta(0));
+    EXPECT_TRUE(packed.block_is_delta(10));
+    EXPECT_GE(6u, packed.block_width(10));
+    EXPECT_EQ(0u, packed.block_width(16));
+    EXPECT_EQ(64u, packed.block_width(19));
+
+    unsigned long long expected_sum = 0;
+    for (auto v : values)
+        expected_sum += static_cast<unsigned long long>(v);
+    const simd::isa saved = simd::active_isa();
+    for (auto mode : {simd::isa::scalar, simd::isa::avx2})
+    {
+        if (mode > simd::detect_isa())
+            continue;
+        simd::active_isa() = mode;
+        EXPECT_EQ(static_cast<long long>(expected_sum), packed.sum());
+        int64_t block[128];
+        EXPECT_EQ(128u, packed.decode_block(10, block));
+        EXPECT_TRUE(std::equal(block, block + 128, values.begin() + 1280));
+    }
+    simd::active_isa() = saved;
+
+    // Ядра суммы для каждой ширины, со смещениями и с разностями
+    packed_massive<uint64_t> widths;
+    uint64_t widths_sum = 0;
+    for (unsigned w = 1; w <= 64; ++w)
+    {
+        uint64_t mask = w == 64 ? ~0ull : (1ull << w) - 1;
+        uint64_t sorted = 0;
+        for (size_t i = 0; i < 128; ++i)
+        {
+            uint64_t v = i == 0 ? 0 : i == 1 ? mask : gen() & mask;
+            widths.push_back(v);
+            widths_sum += v;
+        }
+        for (size_t i = 0; i < 128; ++i)
+        {
+            sorted += (gen() & mask) >> 2;
+            widths.push_back(sorted);
+            widths_sum += sorted;
+        }
+        EXPECT_EQ(w, widths.block_width(2 * (w - 1)));
+    }
+    for (auto mode : {simd::isa::scalar, simd::isa::avx2})
+    {
+        if (mode > simd::detect_isa())
+            continue;
+        simd::active_isa() = mode;
+        EXPECT_EQ(widths_sum, static_cast<uint64_t>(widths.sum()));
+    }
+    simd::active_isa() = saved;
+
+    packed_massive<uint32_t> ids(slvr::container::packing::frame_of_reference);
+    for (uint32_t i = 0; i < 128 * 64; ++i)
+        ids.push_back(1000000 + i);
+    EXPECT_FALSE(ids.block_is_delta(3));
+    EXPECT_EQ(7u, ids.block_width(3));
+    EXPECT_LT(ids.memory_bytes(), ids.size() * sizeof(uint32_t) / 3);
+    EXPECT_EQ(1000000u + 5000u, ids[5000]);
+}
+
+TEST(container, flat_map)
+{
+    using map_t = slvr::container::flat_map<int, int, std::less<int>, slvr::allocator::superK<std::pair<const int, int>>>;
+    auto alloc = slvr::allocator::superK<std::pair<const int, int>>::make_private();
+    map_t fm(alloc);
+    std::map<int, int> reference;
+    std::mt19937 gen(5);
+    for (int i = 0; i < 2000; ++i)
+    {
+        int key = static_cast<int>(gen() % 500);
+        fm[key] += i;
+        reference[key] += i;
+    }
+    EXPECT_EQ(reference.size(), fm.size());
+    EXPECT_TRUE(std::equal(reference.begin(), reference.end(), fm.begin(), [](const auto &a, auto b) {
+        return a.first == b.first && a.second == b.second;
+    }));
+
+    EXPECT_FALSE(fm.insert({7, -1}).second);
+    EXPECT_TRUE(fm.insert_or_assign(1000, 5).second);
+    EXPECT_EQ(5, fm.at(1000));
+    EXPECT_THROW(fm.at(1001), std::out_of_range);
+    EXPECT_EQ(1u, fm.erase(1000));
+    EXPECT_EQ(0u, fm.count(1000));
+    auto it = fm.lower_bound(250);
+    EXPECT_EQ(reference.lower_bound(250)->first, it->first);
+    it = fm.erase(it);
+    EXPECT_EQ(std::next(reference.lower_bound(250))->first, (*it).first);
+    EXPECT_TRUE(fm.contains(reference.begin()->first));
+    EXPECT_EQ(reference.rbegin()->first, fm.rbegin()->first);
+
+    std::vector<std::pair<int, int>> bulk{{5, 50}, {1, 10}, {3, 30}, {1, 11}, {4, 40}};
+    slvr::container::flat_map<int, long> loaded(bulk.begin(), bulk.end());
+    EXPECT_EQ(4u, loaded.size());
+    EXPECT_EQ(10, loaded.at(1));
+    loaded.insert({{2, 20}, {5, 55}, {6, 60}});
+    std::string result;
+    for (auto kv : loaded)
+        result += std::to_string(kv.first) + ":" + std::to_string(kv.second) + " ";
+    EXPECT_STRCASEEQ("1:10 2:20 3:30 4:40 5:50 6:60 ", result.c_str());
+    EXPECT_EQ(210, loaded.values().sum());
+
+    std::vector<std::pair<int, int>> sorted{{1, 1}, {2, 4}, {3, 9}};
+    slvr::container::flat_map<int, int> fast(slvr::container::sorted_unique, sorted.begin(), sorted.end());
+    EXPECT_EQ(9, fast.find(3)->second);
+    EXPECT_TRUE(fast.find(4) == fast.end());
+    auto range = fast.equal_range(2);
+    EXPECT_EQ(1, range.second - range.first);
+    fast.clear();
+    EXPECT_TRUE(fast.empty());
+
+    // Значение не поместилось в лимит superK: ключ не остается без пары
+    using limited_t = slvr::container::flat_map<long, int, std::less<long>, slvr::allocator::superK<std::pair<const long, int>>>;
+    auto limited_alloc = slvr::allocator::superK<std::pair<const long, int>>::make_private();
+    slvr::allocator::superK<int>(limited_alloc).set_limit(10);
+    limited_t limited(limited_alloc);
+    for (long i = 0; i < 10; ++i)
+        limited[i] = static_cast<int>(i);
+    EXPECT_ANY_THROW(limited[10] = 10);
+    EXPECT_EQ(10u, limited.size());
+    EXPECT_EQ(10u, limited.values().size());
+    EXPECT_FALSE(limited.contains(10));
+    std::vector<std::pair<long, int>> more{{20, 2}, {15, 1}};
+    EXPECT_ANY_THROW(limited.insert(more.begin(), more.end()));
+    EXPECT_EQ(10u, limited.size());
+    EXPECT_EQ(10u, limited.values().size());
+    EXPECT_EQ(9, limited.rbegin()->second);
 }
 
 TEST(container, total)